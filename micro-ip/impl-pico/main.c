@@ -18,14 +18,20 @@
 #include <netinet/in.h>
 
 #include <assert.h>
+#include <errno.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include "lwip/pbuf.h"
 #include "lwip/udp.h"
 
-// This is where we track the sockets
+#include "microip_stats.h"
+
+// This is where we track the sockets. Multi-line voters should share
+// a socket (see VoterMux) rather than raising this.
+#ifndef MAX_SOCKETS
 #define MAX_SOCKETS (4)
+#endif
 
 struct impl_socket {
     int active;
@@ -43,6 +49,8 @@ static struct impl_socket Sockets[MAX_SOCKETS] = { };
 // We start at 3 to avoid confusion
 static int FdCounter = 3;
 
+static struct microip_stats Stats = { };
+
 // This callback is dispatched by cyw43_arch_poll() when UDP data has been received
 static void UdpRx(void *arg, struct udp_pcb *pcb, struct pbuf *p, 
     const ip_addr_t *addr, u16_t port) {
@@ -70,12 +78,17 @@ static void UdpRx(void *arg, struct udp_pcb *pcb, struct pbuf *p,
         socket->rxAddrs[socket->rxLen].sin_port = port;
         
         socket->rxLen++;
+        Stats.rxPackets++;
     } else {
-        // #### TODO OVERFLOW COUNTER
+        Stats.rxOverflows++;
         pbuf_free(p);
     }
 }
 
+void microip_get_stats(struct microip_stats* stats) {
+    *stats = Stats;
+}
+
 const char *inet_ntop(int af, const void* src, char* dst, socklen_t size) {
     assert(0);
     return 0;
@@ -219,13 +232,23 @@ ssize_t sendto(int fd, const void *b, size_t len, int flags,
     IP4_ADDR(&targetIp, (addrHost >> 24) & 0xff, (addrHost >> 16) & 0xff, 
         (addrHost >> 8) & 0xff, (addrHost >> 0) & 0xff);
 
+    // NOTE: This comes from the lwIP static heap (see MEM_SIZE)
     struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+    if (p == 0) {
+        Stats.txErrors++;
+        errno = ENOBUFS;
+        return -1;
+    }
     memcpy((uint8_t*)p->payload, b, len);
     err_t err = udp_sendto(Sockets[ix].u, p, &targetIp, portHost);
     pbuf_free(p);
-    if (err == ERR_OK)
+    if (err == ERR_OK) {
+        Stats.txPackets++;
         return len;
-    else 
-        return -1;
+    }
+    Stats.txErrors++;
+    // Tell the caller that it's worth trying again later
+    errno = (err == ERR_MEM || err == ERR_BUF) ? ENOBUFS : EIO;
+    return -1;
 }
 
@@ -0,0 +1,339 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * An in-process UDP network for the host simulation. This replaces the
+ * C library's socket calls for the whole process, so it must only be
+ * linked into simulation tools. Descriptors handed out here start at
+ * SIM_FD_BASE, anything below that is passed through to the kernel by
+ * close() and fcntl().
+ *
+ * Addresses are real sockaddr_in structures (network byte order).
+ */
+// For syscall()
+#define _DEFAULT_SOURCE
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "simnet.h"
+
+#define MAX_SOCKETS (8)
+#define RX_QUEUE_SIZE (8)
+#define MAX_IN_FLIGHT (256)
+#define MAX_PACKET_SIZE (512)
+#define SIM_FD_BASE (1000)
+#define EPHEMERAL_PORT_BASE (40000)
+
+struct sim_packet {
+    uint32_t deliverAt;
+    // Sequence number, keeps delivery order stable for equal times
+    uint32_t seq;
+    struct sockaddr_in src;
+    struct sockaddr_in dst;
+    uint16_t len;
+    uint8_t data[MAX_PACKET_SIZE];
+};
+
+struct sim_socket {
+    int active;
+    int fd;
+    struct sockaddr_in local;
+    struct sim_packet rx[RX_QUEUE_SIZE];
+    unsigned rxLen;
+};
+
+static struct sim_socket Sockets[MAX_SOCKETS];
+static struct sim_packet InFlight[MAX_IN_FLIGHT];
+static unsigned InFlightLen = 0;
+
+static int FdCounter = SIM_FD_BASE;
+static uint16_t PortCounter = EPHEMERAL_PORT_BASE;
+// 10.0.0.2
+static uint32_t LocalAddr = 0x0a000002;
+static uint32_t NowMs = 0;
+static uint32_t SeqCounter = 0;
+static uint32_t Rand = 1;
+
+static uint32_t DelayMs = 0;
+static uint32_t JitterMs = 0;
+static uint32_t LossPpm = 0;
+static int LinkDown = 0;
+
+static struct simnet_stats Stats;
+
+// xorshift32, never seeded with zero
+static uint32_t _rand(void) {
+    Rand ^= Rand << 13;
+    Rand ^= Rand >> 17;
+    Rand ^= Rand << 5;
+    return Rand;
+}
+
+// FNV-1a, only used for the run fingerprint
+static uint32_t _hash(uint32_t h, const void* data, unsigned len) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (unsigned i = 0; i < len; i++)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+static int _findSocket(int fd) {
+    for (unsigned i = 0; i < MAX_SOCKETS; i++)
+        if (Sockets[i].active && Sockets[i].fd == fd)
+            return i;
+    return -1;
+}
+
+static int _findBound(const struct sockaddr_in* a) {
+    for (unsigned i = 0; i < MAX_SOCKETS; i++)
+        if (Sockets[i].active &&
+            Sockets[i].local.sin_port == a->sin_port &&
+            (Sockets[i].local.sin_addr.s_addr == a->sin_addr.s_addr ||
+             Sockets[i].local.sin_addr.s_addr == htonl(INADDR_ANY)))
+            return i;
+    return -1;
+}
+
+// Unbound sockets get an address the first time they send
+static void _autoBind(struct sim_socket* s) {
+    if (s->local.sin_port == 0) {
+        s->local.sin_family = AF_INET;
+        s->local.sin_addr.s_addr = htonl(LocalAddr);
+        s->local.sin_port = htons(PortCounter++);
+    }
+}
+
+void simnet_reset(uint32_t seed) {
+    memset(Sockets, 0, sizeof(Sockets));
+    InFlightLen = 0;
+    FdCounter = SIM_FD_BASE;
+    PortCounter = EPHEMERAL_PORT_BASE;
+    NowMs = 0;
+    SeqCounter = 0;
+    Rand = seed ? seed : 1;
+    LinkDown = 0;
+    memset(&Stats, 0, sizeof(Stats));
+    Stats.fingerprint = 2166136261u;
+}
+
+void simnet_set_link(uint32_t delayMs, uint32_t jitterMs, uint32_t lossPpm) {
+    DelayMs = delayMs;
+    JitterMs = jitterMs;
+    LossPpm = lossPpm;
+}
+
+void simnet_set_down(int down) {
+    LinkDown = down;
+}
+
+void simnet_set_local_addr(uint32_t addr) {
+    LocalAddr = addr;
+}
+
+void simnet_advance(uint32_t nowMs) {
+
+    NowMs = nowMs;
+
+    // Deliver in time order. The in-flight list is small so a repeated
+    // scan for the earliest packet is good enough.
+    while (1) {
+        int best = -1;
+        for (unsigned i = 0; i < InFlightLen; i++) {
+            if ((int32_t)(InFlight[i].deliverAt - nowMs) > 0)
+                continue;
+            if (best == -1 ||
+                (int32_t)(InFlight[i].deliverAt - InFlight[best].deliverAt) < 0 ||
+                (InFlight[i].deliverAt == InFlight[best].deliverAt &&
+                 (int32_t)(InFlight[i].seq - InFlight[best].seq) < 0))
+                best = i;
+        }
+        if (best == -1)
+            break;
+
+        struct sim_packet* p = &InFlight[best];
+        int ix = _findBound(&p->dst);
+        if (ix == -1)
+            Stats.noRoute++;
+        else if (Sockets[ix].rxLen == RX_QUEUE_SIZE)
+            Stats.rxOverflow++;
+        else {
+            Sockets[ix].rx[Sockets[ix].rxLen++] = *p;
+            Stats.delivered++;
+            Stats.fingerprint = _hash(Stats.fingerprint, &p->deliverAt, 4);
+            Stats.fingerprint = _hash(Stats.fingerprint, &p->src, sizeof(p->src));
+            Stats.fingerprint = _hash(Stats.fingerprint, p->data, p->len);
+        }
+
+        // Remove (order of the list doesn't matter)
+        InFlight[best] = InFlight[--InFlightLen];
+    }
+}
+
+uint32_t simnet_next_delivery(uint32_t limitMs) {
+    uint32_t next = limitMs;
+    for (unsigned i = 0; i < InFlightLen; i++)
+        if ((int32_t)(InFlight[i].deliverAt - next) < 0)
+            next = InFlight[i].deliverAt;
+    return next;
+}
+
+void simnet_get_stats(struct simnet_stats* stats) {
+    *stats = Stats;
+}
+
+// ----- Socket API ------------------------------------------------------------
+
+int socket(int domain, int type, int protocol) {
+    if (domain != AF_INET || type != SOCK_DGRAM) {
+        errno = EAFNOSUPPORT;
+        return -1;
+    }
+    for (unsigned i = 0; i < MAX_SOCKETS; i++) {
+        if (!Sockets[i].active) {
+            memset(&Sockets[i], 0, sizeof(Sockets[i]));
+            Sockets[i].active = 1;
+            Sockets[i].fd = FdCounter++;
+            return Sockets[i].fd;
+        }
+    }
+    errno = EMFILE;
+    return -1;
+}
+
+int bind(int fd, const struct sockaddr* addr, socklen_t addrLen) {
+    int ix = _findSocket(fd);
+    if (ix == -1 || addrLen < sizeof(struct sockaddr_in)) {
+        errno = EBADF;
+        return -1;
+    }
+    const struct sockaddr_in* a = (const struct sockaddr_in*)addr;
+    if (_findBound(a) != -1) {
+        errno = EADDRINUSE;
+        return -1;
+    }
+    Sockets[ix].local = *a;
+    return 0;
+}
+
+int setsockopt(int fd, int level, int name, const void* val, socklen_t len) {
+    return _findSocket(fd) == -1 ? -1 : 0;
+}
+
+int close(int fd) {
+    if (fd < SIM_FD_BASE)
+        return syscall(SYS_close, fd);
+    int ix = _findSocket(fd);
+    if (ix == -1) {
+        errno = EBADF;
+        return -1;
+    }
+    Sockets[ix].active = 0;
+    return 0;
+}
+
+int fcntl(int fd, int cmd, ...) {
+    va_list ap;
+    va_start(ap, cmd);
+    long arg = va_arg(ap, long);
+    va_end(ap);
+    if (fd < SIM_FD_BASE)
+        return syscall(SYS_fcntl, fd, cmd, arg);
+    // Simulated sockets are always non-blocking
+    if (_findSocket(fd) == -1) {
+        errno = EBADF;
+        return -1;
+    }
+    return cmd == F_GETFL ? O_NONBLOCK : 0;
+}
+
+ssize_t recvfrom(int fd, void* b, size_t bLen, int flags,
+    struct sockaddr* srcAddr, socklen_t* addrLen) {
+    int ix = _findSocket(fd);
+    if (ix == -1) {
+        errno = EBADF;
+        return -1;
+    }
+    struct sim_socket* s = &Sockets[ix];
+    if (s->rxLen == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    size_t len = s->rx[0].len;
+    if (bLen < len)
+        len = bLen;
+    memcpy(b, s->rx[0].data, len);
+    if (srcAddr && addrLen) {
+        socklen_t l = *addrLen < sizeof(struct sockaddr_in) ? 
+            *addrLen : sizeof(struct sockaddr_in);
+        memcpy(srcAddr, &s->rx[0].src, l);
+        *addrLen = sizeof(struct sockaddr_in);
+    }
+    for (unsigned i = 0; i + 1 < s->rxLen; i++)
+        s->rx[i] = s->rx[i + 1];
+    s->rxLen--;
+    return len;
+}
+
+ssize_t sendto(int fd, const void* b, size_t len, int flags,
+    const struct sockaddr* destAddr, socklen_t addrLen) {
+
+    int ix = _findSocket(fd);
+    if (ix == -1) {
+        errno = EBADF;
+        return -1;
+    }
+    if (len > MAX_PACKET_SIZE || addrLen < sizeof(struct sockaddr_in) ||
+        destAddr->sa_family != AF_INET) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (InFlightLen == MAX_IN_FLIGHT) {
+        Stats.inFlightFull++;
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    _autoBind(&Sockets[ix]);
+    Stats.sent++;
+
+    // The random draws happen whether or not the link is down so that
+    // an outage doesn't shift the rest of the run
+    uint32_t lossDraw = _rand() % 1000000;
+    uint32_t jitter = JitterMs ? _rand() % (JitterMs + 1) : 0;
+    if (LinkDown || lossDraw < LossPpm) {
+        Stats.lost++;
+        return len;
+    }
+
+    struct sim_packet* p = &InFlight[InFlightLen++];
+    p->deliverAt = NowMs + DelayMs + jitter;
+    p->seq = SeqCounter++;
+    p->src = Sockets[ix].local;
+    p->dst = *(const struct sockaddr_in*)destAddr;
+    p->len = len;
+    memcpy(p->data, b, len);
+    return len;
+}
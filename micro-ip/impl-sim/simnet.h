@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Control interface for the in-process network used by the host
+ * simulation (see main.c in this directory). The socket calls themselves
+ * are the normal socket()/bind()/sendto()/recvfrom()/close().
+ *
+ * Time is whatever the simulation says it is: packets sent are held in
+ * flight until simnet_advance() is called with a time at or after their
+ * delivery time. All randomness comes from the seed so a run can be
+ * repeated exactly.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct simnet_stats {
+    uint32_t sent;
+    uint32_t delivered;
+    // Dropped by the loss model or while the link was down
+    uint32_t lost;
+    // Nobody bound to the destination address
+    uint32_t noRoute;
+    // Too many packets in flight
+    uint32_t inFlightFull;
+    // The receiving socket's queue was full
+    uint32_t rxOverflow;
+    // A running hash over every delivery (time, addresses and content),
+    // two runs with the same seed and script should match
+    uint32_t fingerprint;
+};
+
+/**
+ * Closes all sockets, drops anything in flight and reseeds.
+ */
+void simnet_reset(uint32_t seed);
+
+/**
+ * @param delayMs Fixed one-way delay
+ * @param jitterMs Uniform random extra delay 0..jitterMs (packets can
+ * be re-ordered)
+ * @param lossPpm Random loss in parts per million
+ */
+void simnet_set_link(uint32_t delayMs, uint32_t jitterMs, uint32_t lossPpm);
+
+/**
+ * While the link is down everything sent is lost.
+ */
+void simnet_set_down(int down);
+
+/**
+ * The address (host order) that unbound sockets send from.
+ */
+void simnet_set_local_addr(uint32_t addr);
+
+/**
+ * Delivers everything that is due at or before the given time.
+ */
+void simnet_advance(uint32_t nowMs);
+
+/**
+ * @returns The delivery time of the next packet in flight, or limitMs
+ * if nothing will arrive before then.
+ */
+uint32_t simnet_next_delivery(uint32_t limitMs);
+
+void simnet_get_stats(struct simnet_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
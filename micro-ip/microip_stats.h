@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Counters kept by the socket layer, totals across all sockets since
+ * boot.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct microip_stats {
+    uint32_t rxPackets;
+    // Dropped because the socket's receive queue was full
+    uint32_t rxOverflows;
+    uint32_t txPackets;
+    // Includes ENOBUFS (out of lwIP buffers)
+    uint32_t txErrors;
+};
+
+void microip_get_stats(struct microip_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,134 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cmath>
+
+#include "AudioConditioner.h"
+
+namespace kc1fsz {
+
+static int16_t sat16(int32_t v) {
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+}
+
+// RBJ cookbook high-pass
+static void makeHighPass(AudioConditioner::Biquad& bq, float f0, float q) {
+    const float w0 = 2.0f * 3.1415926f * f0 / 8000.0f;
+    const float c = std::cos(w0);
+    const float alpha = std::sin(w0) / (2.0f * q);
+    const float a0 = 1.0f + alpha;
+    bq.setFloat((1.0f + c) / 2.0f / a0, -(1.0f + c) / a0, (1.0f + c) / 2.0f / a0,
+        -2.0f * c / a0, (1.0f - alpha) / a0);
+}
+
+void AudioConditioner::Biquad::setFloat(float fb0, float fb1, float fb2,
+    float fa1, float fa2) {
+    b0 = std::lround(fb0 * 16384.0f);
+    b1 = std::lround(fb1 * 16384.0f);
+    b2 = std::lround(fb2 * 16384.0f);
+    a1 = std::lround(fa1 * 16384.0f);
+    a2 = std::lround(fa2 * 16384.0f);
+}
+
+void AudioConditioner::Biquad::process(int16_t* frame, unsigned len) {
+    // Locals so the compiler can keep the state in registers
+    int32_t lx1 = x1, lx2 = x2, ly1 = y1, ly2 = y2;
+    for (unsigned i = 0; i < len; i++) {
+        int32_t x = frame[i];
+        int32_t acc = b0 * x + b1 * lx1 + b2 * lx2 - a1 * ly1 - a2 * ly2;
+        int32_t y = sat16(acc >> 14);
+        lx2 = lx1;
+        lx1 = x;
+        ly2 = ly1;
+        ly1 = y;
+        frame[i] = y;
+    }
+    x1 = lx1; x2 = lx2; y1 = ly1; y2 = ly2;
+}
+
+AudioConditioner::AudioConditioner() {
+    // 4th order Butterworth = two 2nd order sections with these Qs
+    makeHighPass(_hpf[0], 300.0f, 0.5412f);
+    makeHighPass(_hpf[1], 300.0f, 1.3066f);
+    // First order 750us de-emphasis: y = (1 - a) * x + a * y1
+    const float a = std::exp(-1.0f / (8000.0f * 750e-6f));
+    _deemph.setFloat(1.0f - a, 0, 0, -a, 0);
+}
+
+void AudioConditioner::reset() {
+    _hpf[0].reset();
+    _hpf[1].reset();
+    _deemph.reset();
+    _agcGainQ8 = 256;
+}
+
+void AudioConditioner::process(int16_t* frame, unsigned len) {
+
+    if (_hpfOn || _deemphOn) {
+        // Half scale for accumulator headroom
+        for (unsigned i = 0; i < len; i++)
+            frame[i] >>= 1;
+        if (_hpfOn) {
+            _hpf[0].process(frame, len);
+            _hpf[1].process(frame, len);
+        }
+        if (_deemphOn)
+            _deemph.process(frame, len);
+        for (unsigned i = 0; i < len; i++)
+            frame[i] = sat16((int32_t)frame[i] << 1);
+    }
+
+    if (_agcOn)
+        _agc(frame, len);
+}
+
+void AudioConditioner::_agc(int16_t* frame, unsigned len) {
+
+    int32_t peak = 0;
+    for (unsigned i = 0; i < len; i++) {
+        int32_t a = frame[i] < 0 ? -frame[i] : frame[i];
+        if (a > peak)
+            peak = a;
+    }
+
+    // Fast attack, slow release
+    int32_t oldGain = _agcGainQ8;
+    int32_t newGain = oldGain;
+    if (peak > AGC_SQUELCH) {
+        int32_t want = (AGC_TARGET * 256) / peak;
+        if (want < oldGain)
+            newGain = oldGain - (oldGain - want) / 4;
+        // Rounded up so that the release doesn't stall short of the
+        // target once the difference is under 1/64
+        else
+            newGain = oldGain + (want - oldGain + 63) / 64;
+        if (newGain < AGC_MIN_GAIN) newGain = AGC_MIN_GAIN;
+        if (newGain > AGC_MAX_GAIN) newGain = AGC_MAX_GAIN;
+    }
+    _agcGainQ8 = newGain;
+
+    // Ramp across the frame to avoid zipper noise (gain in Q16 here)
+    int32_t g = oldGain << 8;
+    const int32_t step = ((newGain - oldGain) << 8) / (int32_t)len;
+    for (unsigned i = 0; i < len; i++) {
+        g += step;
+        frame[i] = sat16((frame[i] * (g >> 8)) >> 8);
+    }
+}
+
+}
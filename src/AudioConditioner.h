@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace kc1fsz {
+
+/**
+ * Fixed-point receive audio conditioning, applied in place to each
+ * 8 kHz frame before it is sent to the server:
+ *
+ * 1. A 4th order Butterworth high-pass at 300 Hz (two biquads) to strip
+ *    CTCSS and other sub-audible content.
+ * 2. Optional 6 dB/octave de-emphasis (750us, first order) for receivers
+ *    that provide flat discriminator audio.
+ * 3. A slow AGC that brings the level towards a fixed target.
+ *
+ * Coefficients are Q14 and are computed once at construction.
+ * The filters run at half scale to leave a bit of headroom in the 32-bit
+ * accumulators. There is no allocation and no floating point on the
+ * per-frame path.
+ */
+class AudioConditioner {
+public:
+
+    AudioConditioner();
+
+    void setHighPass(bool on) { _hpfOn = on; }
+    void setDeemphasis(bool on) { _deemphOn = on; }
+    void setAgc(bool on) { _agcOn = on; }
+
+    bool isActive() const { return _hpfOn || _deemphOn || _agcOn; }
+
+    /**
+     * Runs the enabled stages on the frame, in place.
+     */
+    void process(int16_t* frame, unsigned len);
+
+    void reset();
+
+    /**
+     * @returns The current AGC gain in Q8 (256 = unity)
+     */
+    int32_t getAgcGain() const { return _agcGainQ8; }
+
+    // Peak level the AGC aims for (about -12 dBFS)
+    static const int32_t AGC_TARGET = 8192;
+    // Limits on the AGC gain (Q8)
+    static const int32_t AGC_MIN_GAIN = 64;
+    static const int32_t AGC_MAX_GAIN = 16 * 256;
+    // Frames with a peak below this are treated as silence and leave
+    // the gain alone
+    static const int32_t AGC_SQUELCH = 64;
+
+    /**
+     * A Direct Form I biquad with Q14 coefficients. Public so that it
+     * can be exercised on its own.
+     */
+    struct Biquad {
+        int32_t b0 = 1 << 14, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+        int32_t x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+        void setFloat(float fb0, float fb1, float fb2, float fa1, float fa2);
+        void reset() { x1 = x2 = y1 = y2 = 0; }
+        void process(int16_t* frame, unsigned len);
+    };
+
+private:
+
+    void _agc(int16_t* frame, unsigned len);
+
+    bool _hpfOn = false;
+    bool _deemphOn = false;
+    bool _agcOn = false;
+
+    Biquad _hpf[2];
+    Biquad _deemph;
+    int32_t _agcGainQ8 = 256;
+};
+
+}
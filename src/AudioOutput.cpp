@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "kc1fsz-tools/Log.h"
+
+#include "AudioOutput.h"
+
+namespace kc1fsz {
+
+AudioOutput::AudioOutput(Log& log, Clock& clock)
+:   _log(log),
+    _clock(clock) {
+}
+
+void AudioOutput::consume(const Message& m) {
+
+    if (!m.isVoice() || m.size() != FRAME_SIZE)
+        return;
+
+    // Make room by discarding the oldest audio
+    if (getFill() + FRAME_SIZE > RING_SIZE) {
+        _rd = _wr + FRAME_SIZE - RING_SIZE;
+        _frac = 0;
+        _stats.overruns++;
+    }
+
+    // Decode the whole frame in one batch, then copy into the ring. The
+    // ring size is a multiple of the frame size but the write pointer
+    // may not be frame-aligned after an overrun, so wrap per sample.
+    int16_t pcm[FRAME_SIZE];
+    _tc.decode(m.body(), FRAME_SIZE, pcm, FRAME_SIZE);
+    for (unsigned i = 0; i < FRAME_SIZE; i++)
+        _ring[(_wr + i) & (RING_SIZE - 1)] = pcm[i];
+    _wr += FRAME_SIZE;
+    _stats.framesIn++;
+}
+
+void AudioOutput::render(int16_t* out, unsigned len) {
+
+    if (!_primed && getFill() >= TARGET_FILL)
+        _primed = true;
+
+    // Steer the resampling ratio using the (smoothed) fill level. Running
+    // fuller than the target means the server is faster than we are.
+    if (_primed) {
+        int32_t err = (int32_t)getFill() - (int32_t)TARGET_FILL;
+        _fillErrQ4 += ((err << 4) - _fillErrQ4) / 16;
+        int32_t corr = _fillErrQ4 >> 4;
+        if (corr > MAX_CORRECTION) corr = MAX_CORRECTION;
+        if (corr < -MAX_CORRECTION) corr = -MAX_CORRECTION;
+        _step = 0x10000 + corr;
+    }
+
+    for (unsigned i = 0; i < len; i++) {
+        // Interpolation needs the sample after the current one
+        if (!_primed || getFill() < 2) {
+            if (_primed) {
+                _primed = false;
+                _stats.underruns++;
+            }
+            out[i] = 0;
+            continue;
+        }
+        int32_t s0 = _ring[_rd & (RING_SIZE - 1)];
+        int32_t s1 = _ring[(_rd + 1) & (RING_SIZE - 1)];
+        // Q15 weight so that the product fits in 32 bits
+        out[i] = (int16_t)(s0 + (((s1 - s0) * (int32_t)(_frac >> 1)) >> 15));
+        _frac += _step;
+        _rd += _frac >> 16;
+        _frac &= 0xffff;
+    }
+
+    _stats.samplesOut += len;
+}
+
+int32_t AudioOutput::getDriftPpm() const {
+    return ((_step - 0x10000) * 15625) / 1024;
+}
+
+void AudioOutput::tenSecTick() {
+    if (_stats.framesIn == 0)
+        return;
+    _log.info("Audio out frames %u, underruns %u, overruns %u, fill %u, drift %d ppm",
+        _stats.framesIn, _stats.underruns, _stats.overruns, getFill(), getDriftPpm());
+}
+
+}
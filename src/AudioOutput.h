@@ -0,0 +1,112 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+// amp-core
+#include "Transcoder_G711_ULAW.h"
+#include "Runnable2.h"
+#include "Message.h"
+#include "MessageConsumer.h"
+
+namespace kc1fsz {
+
+class Log;
+class Clock;
+
+/**
+ * The playback side of the voter. μ-law audio frames that come back
+ * from the server are decoded into a ring buffer and then pulled out
+ * by an output driver (PWM on the Pico, a WAV file on the host) at the
+ * driver's own sample clock.
+ *
+ * The server's 8 kHz and the local crystal never agree exactly, so
+ * the samples are pulled through a linear-interpolating resampler whose
+ * ratio is steered by the ring fill level. This keeps the ring near
+ * its target depth without ever dropping or repeating whole frames.
+ */
+class AudioOutput : public Runnable2, public MessageConsumer {
+public:
+
+    static const unsigned FRAME_SIZE = 160;
+    // Must be a power of two
+    static const unsigned RING_SIZE = 1024;
+    // Where we try to keep the ring (in samples)
+    static const unsigned TARGET_FILL = 2 * FRAME_SIZE;
+    // Largest allowed resampling correction, in 1/65536 (about 0.5%)
+    static const int32_t MAX_CORRECTION = 328;
+
+    struct Stats {
+        uint32_t framesIn = 0;
+        uint32_t samplesOut = 0;
+        // Times the ring ran dry
+        uint32_t underruns = 0;
+        // Times the oldest audio was discarded to make room
+        uint32_t overruns = 0;
+    };
+
+    AudioOutput(Log& log, Clock& clock);
+
+    /**
+     * Called by the output driver to get the next block of samples at
+     * the local sample rate. Silence is produced when nothing is
+     * available.
+     */
+    void render(int16_t* out, unsigned len);
+
+    const Stats& getStats() const { return _stats; }
+
+    /**
+     * @returns The current rate correction in parts per million. Positive
+     * means we are consuming faster than nominal (local clock is slow).
+     */
+    int32_t getDriftPpm() const;
+
+    unsigned getFill() const { return _wr - _rd; }
+
+    // ----- MessageConsumer -------------------------------------------------
+
+    virtual void consume(const Message& m);
+
+    // ----- Runnable -------------------------------------------------------
+
+    virtual void tenSecTick();
+
+private:
+
+    Log& _log;
+    Clock& _clock;
+
+    Transcoder_G711_ULAW _tc;
+
+    int16_t _ring[RING_SIZE];
+    // Free-running counters, the ring index is the low bits
+    uint32_t _wr = 0;
+    uint32_t _rd = 0;
+    // Fractional read position and step (Q16)
+    uint32_t _frac = 0;
+    int32_t _step = 0x10000;
+    // Smoothed fill error (Q4)
+    int32_t _fillErrQ4 = 0;
+    // Output is held off after startup/underrun until the ring refills
+    bool _primed = false;
+
+    Stats _stats;
+};
+
+}
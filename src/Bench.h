@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC (1)
+#else
+#define BENCH_HAS_TSC (0)
+#endif
+
+namespace kc1fsz {
+
+/**
+ * A small host-side micro-benchmark harness (used by voter-bench).
+ *
+ * Each benchmark is calibrated so that one repetition (a batch of
+ * calls) takes at least MIN_REP_NS, then run for a number of warmup
+ * repetitions that are thrown away, then for the measured repetitions.
+ * The per-call median, p99 and minimum across repetitions are reported
+ * along with the time stamp counter where the CPU has one. These are 
+ * statistics of the batch means (the time for a repetition divided by
+ * its calls), so the p99 shows slow batches rather than single slow 
+ * calls, which are averaged away.
+ */
+class Bench {
+public:
+
+    static const unsigned MAX_REPS = 1000;
+    static const uint64_t MIN_REP_NS = 50000;
+
+    struct Result {
+        const char* name = "";
+        unsigned reps = 0;
+        unsigned itersPerRep = 0;
+        double medianNs = 0;
+        // The p99 of the batch means, not of individual calls
+        double p99BatchNs = 0;
+        double minNs = 0;
+        // Time stamp counter ticks per call, or negative if there is none
+        double medianTsc = -1;
+        // Heap allocations over the whole run (filled in by the caller),
+        // or negative if not counted
+        int64_t allocs = -1;
+    };
+
+    /**
+     * Stops the compiler from optimizing away a result.
+     */
+    static void keep(const void* p) {
+        asm volatile("" : : "g"(p) : "memory");
+    }
+
+    Bench(unsigned warmupReps, unsigned reps)
+    :   _warmupReps(warmupReps),
+        _reps(std::min(reps, MAX_REPS)) {
+    }
+
+    template<typename F>
+    Result run(const char* name, F&& f) {
+
+        Result r;
+        r.name = name;
+        r.reps = _reps;
+
+        // Calibrate
+        unsigned iters = 1;
+        while (iters < (1u << 24) && _timeRep(f, iters) < MIN_REP_NS)
+            iters *= 2;
+        r.itersPerRep = iters;
+
+        for (unsigned i = 0; i < _warmupReps; i++)
+            _timeRep(f, iters);
+
+        for (unsigned i = 0; i < _reps; i++) {
+#if BENCH_HAS_TSC
+            uint64_t t0 = __rdtsc();
+#endif
+            _ns[i] = (double)_timeRep(f, iters) / iters;
+#if BENCH_HAS_TSC
+            _tsc[i] = (double)(__rdtsc() - t0) / iters;
+#endif
+        }
+
+        std::sort(_ns, _ns + _reps);
+        r.medianNs = _ns[_reps / 2];
+        r.p99BatchNs = _ns[(_reps * 99) / 100 < _reps ? (_reps * 99) / 100 : _reps - 1];
+        r.minNs = _ns[0];
+#if BENCH_HAS_TSC
+        std::sort(_tsc, _tsc + _reps);
+        r.medianTsc = _tsc[_reps / 2];
+#endif
+        return r;
+    }
+
+    /**
+     * Writes one result as a JSON object (no trailing comma/newline).
+     */
+    static void writeJson(FILE* f, const Result& r) {
+        fprintf(f, "{\"name\":\"%s\",\"reps\":%u,\"iters_per_rep\":%u,"
+            "\"median_ns\":%.2f,\"p99_batch_ns\":%.2f,\"min_ns\":%.2f,",
+            r.name, r.reps, r.itersPerRep, r.medianNs, r.p99BatchNs, r.minNs);
+        if (r.medianTsc >= 0)
+            fprintf(f, "\"median_tsc\":%.1f,", r.medianTsc);
+        else
+            fprintf(f, "\"median_tsc\":null,");
+        if (r.allocs >= 0)
+            fprintf(f, "\"allocs\":%lld,", (long long)r.allocs);
+        fprintf(f, "\"ops_per_sec\":%.0f}", r.medianNs > 0 ? 1e9 / r.medianNs : 0.0);
+    }
+
+private:
+
+    template<typename F>
+    static uint64_t _timeRep(F& f, unsigned iters) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < iters; i++)
+            f();
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    }
+
+    const unsigned _warmupReps;
+    const unsigned _reps;
+    double _ns[MAX_REPS];
+    double _tsc[MAX_REPS];
+};
+
+}
@@ -0,0 +1,158 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdio>
+#include <cstring>
+
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/Clock.h"
+
+#include "DeferredLog.h"
+
+namespace kc1fsz {
+
+DeferredLog::DeferredLog(Log& log, Clock& clock)
+:   _log(log),
+    _clock(clock) {
+}
+
+uint32_t DeferredLog::_now() const {
+    return _clock.time();
+}
+
+bool DeferredLog::run2() {
+    drain(DRAIN_PER_PASS);
+    // Never claim more work, formatting should not starve anyone
+    return false;
+}
+
+unsigned DeferredLog::drain(unsigned maxRecords) {
+
+    unsigned count = 0;
+    char buf[160];
+
+    while (count < maxRecords) {
+        const uint32_t t = _tail.load(std::memory_order_relaxed);
+        if (t == _head.load(std::memory_order_acquire))
+            break;
+        const Record& r = _ring[t & (RING_SIZE - 1)];
+        _format(r, buf, sizeof(buf));
+        // The record is no longer needed once it has been formatted
+        const uint32_t stampMs = r.stampMs;
+        const Level level = r.level;
+        _tail.store(t + 1, std::memory_order_release);
+
+        if (level == LEVEL_ERROR)
+            _log.error("[%u] %s", (unsigned)stampMs, buf);
+        else
+            _log.info("[%u] %s", (unsigned)stampMs, buf);
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * Walks the format string and hands each conversion to snprintf along 
+ * with its recorded argument. Length modifiers in the original format
+ * are replaced with the ones that match the recorded type.
+ */
+void DeferredLog::_format(const Record& r, char* out, unsigned outCapacity) const {
+
+    unsigned o = 0;
+    unsigned argIx = 0;
+    const char* p = r.fmt;
+
+    auto room = [&]() { return o < outCapacity ? outCapacity - o : 0; };
+    auto advance = [&](int n) {
+        if (n > 0)
+            o = (o + n < outCapacity) ? o + n : outCapacity - 1;
+    };
+
+    while (*p && o + 1 < outCapacity) {
+
+        if (*p != '%') {
+            out[o++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[o++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Collect flags, width and precision
+        char spec[16];
+        unsigned s = 0;
+        spec[s++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && s < sizeof(spec) - 4)
+            spec[s++] = *p++;
+        // Drop the caller's length modifiers
+        while (*p && strchr("hlzjtLq", *p))
+            p++;
+        const char conv = *p;
+        if (!conv)
+            break;
+        p++;
+
+        if (argIx >= r.argCount) {
+            advance(snprintf(out + o, room(), "<?>"));
+            continue;
+        }
+        const Arg& a = r.args[argIx++];
+
+        if (conv == 's' || conv == 'p') {
+            spec[s++] = conv;
+            spec[s] = 0;
+            if (a.type != ARG_POINTER)
+                advance(snprintf(out + o, room(), "<?>"));
+            else if (conv == 's')
+                advance(snprintf(out + o, room(), spec, 
+                    a.p ? (const char*)a.p : "(null)"));
+            else
+                advance(snprintf(out + o, room(), spec, a.p));
+        }
+        else if (strchr("feEgGaA", conv)) {
+            spec[s++] = conv;
+            spec[s] = 0;
+            double d = (a.type == ARG_DOUBLE) ? a.d :
+                (a.type == ARG_SIGNED) ? (double)a.i : (double)a.u;
+            advance(snprintf(out + o, room(), spec, d));
+        }
+        else if (conv == 'c') {
+            spec[s++] = conv;
+            spec[s] = 0;
+            advance(snprintf(out + o, room(), spec, (int)a.i));
+        }
+        else if (strchr("diuxXo", conv)) {
+            spec[s++] = 'l';
+            spec[s++] = 'l';
+            spec[s++] = conv;
+            spec[s] = 0;
+            if (a.type == ARG_SIGNED)
+                advance(snprintf(out + o, room(), spec, (long long)a.i));
+            else
+                advance(snprintf(out + o, room(), spec, (unsigned long long)a.u));
+        }
+        else {
+            advance(snprintf(out + o, room(), "<?>"));
+        }
+    }
+
+    out[o < outCapacity ? o : outCapacity - 1] = 0;
+}
+
+}
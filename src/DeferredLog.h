@@ -0,0 +1,172 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <type_traits>
+
+#include "kc1fsz-tools/Log.h"
+
+#include "Runnable2.h"
+
+namespace kc1fsz {
+
+class Clock;
+
+/**
+ * A logger for hot paths. The call site only stores the format string
+ * pointer, a timestamp and the raw arguments into a lock-free ring; the
+ * printf-style formatting and the (slow, synchronous) write to the real
+ * Log happen later from run2(), a few records per pass.
+ *
+ * Rules for callers:
+ * - The format string and any %s arguments must outlive the record
+ *   (string literals are fine, stack buffers are not).
+ * - At most MAX_ARGS arguments. Integers, pointers, enums and doubles
+ *   are supported. Length modifiers in the format are ignored since the
+ *   argument types are recorded.
+ * - There is a single producer context (the main loop). Records are
+ *   never blocked on: when the ring is full the record is dropped and
+ *   counted.
+ */
+class DeferredLog : public Runnable2 {
+public:
+
+    // Must be a power of two
+    static const unsigned RING_SIZE = 64;
+    static const unsigned MAX_ARGS = 4;
+    // Records formatted per run2() call
+    static const unsigned DRAIN_PER_PASS = 2;
+
+    DeferredLog(Log& log, Clock& clock);
+
+    template<typename... Args>
+    void info(const char* fmt, Args... args) {
+        _record(LEVEL_INFO, fmt, args...);
+    }
+
+    template<typename... Args>
+    void error(const char* fmt, Args... args) {
+        _record(LEVEL_ERROR, fmt, args...);
+    }
+
+    /**
+     * Formats and writes up to the given number of records.
+     * @returns The number written.
+     */
+    unsigned drain(unsigned maxRecords);
+
+    uint32_t getOverflowCount() const { return _overflowCount; }
+
+    // ----- Runnable -------------------------------------------------------
+
+    virtual bool run2();
+
+private:
+
+    enum Level : uint8_t { LEVEL_INFO, LEVEL_ERROR };
+    enum ArgType : uint8_t { ARG_SIGNED, ARG_UNSIGNED, ARG_POINTER, ARG_DOUBLE };
+
+    struct Arg {
+        ArgType type;
+        union {
+            int64_t i;
+            uint64_t u;
+            const void* p;
+            double d;
+        };
+    };
+
+    struct Record {
+        const char* fmt;
+        uint32_t stampMs;
+        Level level;
+        uint8_t argCount;
+        Arg args[MAX_ARGS];
+    };
+
+    template<typename T>
+    static void _pack(Arg& a, T v) {
+        if constexpr (std::is_enum_v<T>) {
+            _pack(a, (std::underlying_type_t<T>)v);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            a.type = ARG_DOUBLE;
+            a.d = v;
+        } else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>) {
+            a.type = ARG_POINTER;
+            a.p = (const void*)v;
+        } else if constexpr (std::is_signed_v<T>) {
+            a.type = ARG_SIGNED;
+            a.i = v;
+        } else {
+            a.type = ARG_UNSIGNED;
+            a.u = v;
+        }
+    }
+
+    template<typename... Args>
+    void _record(Level level, const char* fmt, Args... args) {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "Too many arguments for DeferredLog");
+        const uint32_t h = _head.load(std::memory_order_relaxed);
+        if (h - _tail.load(std::memory_order_acquire) == RING_SIZE) {
+            _overflowCount++;
+            return;
+        }
+        Record& r = _ring[h & (RING_SIZE - 1)];
+        r.fmt = fmt;
+        r.stampMs = _now();
+        r.level = level;
+        r.argCount = sizeof...(Args);
+        unsigned i = 0;
+        (_pack(r.args[i++], args), ...);
+        (void)i;
+        _head.store(h + 1, std::memory_order_release);
+    }
+
+    uint32_t _now() const;
+    void _format(const Record& r, char* out, unsigned outCapacity) const;
+
+    Log& _log;
+    Clock& _clock;
+    Record _ring[RING_SIZE];
+    std::atomic<uint32_t> _head { 0 };
+    std::atomic<uint32_t> _tail { 0 };
+    uint32_t _overflowCount = 0;
+};
+
+/**
+ * Used on the hot paths: the record goes to the DeferredLog when there
+ * is one, otherwise straight to the Log.
+ */
+template<typename... Args>
+void hotError(Log& log, DeferredLog* dlog, const char* fmt, Args... args) {
+    if (dlog)
+        dlog->error(fmt, args...);
+    else
+        log.error(fmt, args...);
+}
+
+template<typename... Args>
+void hotInfo(Log& log, DeferredLog* dlog, const char* fmt, Args... args) {
+    if (dlog)
+        dlog->info(fmt, args...);
+    else
+        log.info(fmt, args...);
+}
+
+}
@@ -0,0 +1,239 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <malloc.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef PICO_BOARD
+#include "pico/platform.h"
+#endif
+
+#include "kc1fsz-tools/Log.h"
+
+#include "HeapGuard.h"
+
+namespace kc1fsz {
+
+// These are plain statics (no constructors) so they are usable from
+// operator new before any C++ static initialization has happened.
+static volatile bool Armed = false;
+static volatile uint32_t AllocCount = 0;
+static volatile uint32_t ArmedAllocCount = 0;
+
+HeapGuard::HeapGuard(Log& log)
+:   _log(log) {
+}
+
+void HeapGuard::arm() {
+    _armedHeapInUse = getHeapInUse();
+    Armed = true;
+    _log.info("Heap guard armed (%u allocations, %u bytes in use)",
+        (unsigned)AllocCount, (unsigned)_armedHeapInUse);
+}
+
+bool HeapGuard::isArmed() const {
+    return Armed;
+}
+
+uint32_t HeapGuard::getAllocCount() {
+    return AllocCount;
+}
+
+uint32_t HeapGuard::getArmedAllocCount() {
+    return ArmedAllocCount;
+}
+
+uint32_t HeapGuard::getHeapInUse() {
+#ifdef __GLIBC__
+    return mallinfo2().uordblks;
+#else
+    return mallinfo().uordblks;
+#endif
+}
+
+void HeapGuard::tenSecTick() {
+#ifndef AMP_VOTER_HEAP_GUARD
+    // Without the hooks only the net growth can be seen. Each new level
+    // is logged once.
+    if (!Armed)
+        return;
+    uint32_t inUse = getHeapInUse();
+    if (inUse > _armedHeapInUse) {
+        _log.error("Heap grew after startup (%u -> %u bytes)",
+            (unsigned)_armedHeapInUse, (unsigned)inUse);
+        _armedHeapInUse = inUse;
+    }
+#endif
+}
+
+void HeapGuard::noteAlloc(const char* what, std::size_t size) {
+    AllocCount = AllocCount + 1;
+    if (Armed) {
+        ArmedAllocCount = ArmedAllocCount + 1;
+        _fail(what, size);
+    }
+}
+
+void HeapGuard::_fail(const char* what, unsigned size) {
+#ifdef AMP_VOTER_HEAP_GUARD
+    // The report itself may allocate
+    Armed = false;
+#ifdef PICO_BOARD
+    panic("Heap allocation after startup: %s (%u bytes)", what, size);
+#else
+    fprintf(stderr, "Heap allocation after startup: %s (%u bytes)\n", what, size);
+    abort();
+#endif
+#endif
+}
+
+}
+
+#ifdef AMP_VOTER_HEAP_GUARD
+
+// The C heap, wrapped at link time (-Wl,--wrap=malloc etc.). The 
+// __real_ versions are the C library's. On the Pico these stand in for 
+// pico_malloc's wrappers, so they also keep its out-of-memory panic. 
+// pico_malloc's mutex isn't needed since only one core allocates.
+
+extern "C" {
+
+void* __real_malloc(std::size_t size);
+void* __real_calloc(std::size_t n, std::size_t size);
+void* __real_realloc(void* p, std::size_t size);
+void __real_free(void* p);
+
+static void* checkedAlloc(void* p, std::size_t size) {
+    if (!p && size) {
+#ifdef PICO_BOARD
+        panic("Out of memory (%u bytes)", (unsigned)size);
+#else
+        abort();
+#endif
+    }
+    return p;
+}
+
+void* __wrap_malloc(std::size_t size) {
+    kc1fsz::HeapGuard::noteAlloc("malloc", size);
+    return checkedAlloc(__real_malloc(size), size);
+}
+
+void* __wrap_calloc(std::size_t n, std::size_t size) {
+    kc1fsz::HeapGuard::noteAlloc("calloc", n * size);
+    return checkedAlloc(__real_calloc(n, size), n * size);
+}
+
+void* __wrap_realloc(void* p, std::size_t size) {
+    kc1fsz::HeapGuard::noteAlloc("realloc", size);
+    return checkedAlloc(__real_realloc(p, size), size);
+}
+
+void __wrap_free(void* p) {
+    __real_free(p);
+}
+
+}
+
+// Replacements for the global allocation functions. On the Pico the SDK
+// provides its own versions of these, so the build must also define
+// PICO_CXX_DISABLE_ALLOCATION_OVERRIDES (see CMakeLists.txt). They go 
+// to the real malloc so that an allocation is only counted once.
+
+static void* guardedAlloc(std::size_t size) {
+    kc1fsz::HeapGuard::noteAlloc("operator new", size);
+    return checkedAlloc(__real_malloc(size == 0 ? 1 : size), 1);
+}
+
+static void* guardedAlignedAlloc(std::size_t size, std::align_val_t align) {
+    kc1fsz::HeapGuard::noteAlloc("operator new", size);
+    return checkedAlloc(memalign((std::size_t)align, size == 0 ? 1 : size), 1);
+}
+
+void* operator new(std::size_t size) {
+    return guardedAlloc(size);
+}
+
+void* operator new[](std::size_t size) {
+    return guardedAlloc(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    kc1fsz::HeapGuard::noteAlloc("operator new", size);
+    return __real_malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    kc1fsz::HeapGuard::noteAlloc("operator new", size);
+    return __real_malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    return guardedAlignedAlloc(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return guardedAlignedAlloc(size, align);
+}
+
+void* operator new(std::size_t size, std::align_val_t align, 
+    const std::nothrow_t&) noexcept {
+    kc1fsz::HeapGuard::noteAlloc("operator new", size);
+    return memalign((std::size_t)align, size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, 
+    const std::nothrow_t&) noexcept {
+    kc1fsz::HeapGuard::noteAlloc("operator new", size);
+    return memalign((std::size_t)align, size == 0 ? 1 : size);
+}
+
+void operator delete(void* p) noexcept {
+    __real_free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    __real_free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    __real_free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    __real_free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    __real_free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    __real_free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    __real_free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    __real_free(p);
+}
+
+#endif
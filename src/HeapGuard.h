@@ -0,0 +1,99 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "Runnable2.h"
+
+namespace kc1fsz {
+
+class Log;
+
+/**
+ * Enforces an allocation-free steady state. Everything is allowed to
+ * allocate during startup, but once arm() has been called any heap
+ * allocation is treated as a fatal error.
+ *
+ * When the build is configured with AMP_VOTER_HEAP_GUARD every 
+ * allocation is counted, and fails immediately after arming:
+ *
+ * 1. The global operator new/delete (including the aligned forms) are
+ *    replaced.
+ * 2. malloc/calloc/realloc/free are wrapped at link time 
+ *    (-Wl,--wrap=malloc etc., see CMakeLists.txt), which catches the
+ *    allocations made from C code (i.e. the SDK and lwIP) that never go
+ *    through operator new. On the Pico these wrappers take the place 
+ *    of pico_malloc's. On the host only calls from the program's own
+ *    objects are wrapped, not those inside the shared C/C++ libraries.
+ *
+ * Without AMP_VOTER_HEAP_GUARD nothing is hooked, and tenSecTick() can
+ * only log growth of the C heap in use since arm(). That misses 
+ * anything freed before the sample. The host tools (voter-sim, 
+ * voter-bench) are always built with AMP_VOTER_HEAP_GUARD.
+ */
+class HeapGuard : public Runnable2 {
+public:
+
+    HeapGuard(Log& log);
+
+    /**
+     * Marks the end of startup. Call this immediately before entering
+     * the event loop.
+     */
+    void arm();
+
+    bool isArmed() const;
+
+    /**
+     * @returns The number of allocations (operator new, malloc, calloc,
+     * realloc) since boot.
+     */
+    static uint32_t getAllocCount();
+
+    /**
+     * @returns The number of allocations since arm(). This will always 
+     * be zero in a healthy system.
+     */
+    static uint32_t getArmedAllocCount();
+
+    /**
+     * @returns The number of C heap bytes in use right now.
+     */
+    static uint32_t getHeapInUse();
+
+    // ----- Runnable -------------------------------------------------------
+
+    virtual void tenSecTick();
+
+    /**
+     * Internal: called from the operator new replacements and the 
+     * malloc wrappers.
+     */
+    static void noteAlloc(const char* what, std::size_t size);
+
+private:
+
+    static void _fail(const char* what, unsigned size);
+
+    Log& _log;
+    // C heap in use at arm() or the last report
+    uint32_t _armedHeapInUse = 0;
+};
+
+}
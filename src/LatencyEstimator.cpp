@@ -0,0 +1,73 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "LatencyEstimator.h"
+
+namespace kc1fsz {
+
+void LatencyEstimator::reset() {
+    _count = 0;
+    _min = 0;
+    _max = 0;
+    _last = 0;
+    _meanQ4 = 0;
+    for (unsigned i = 0; i < BUCKET_COUNT; i++)
+        _buckets[i] = 0;
+}
+
+void LatencyEstimator::addSample(int32_t ms) {
+
+    if (_count == 0) {
+        _min = ms;
+        _max = ms;
+        _meanQ4 = ms << 4;
+    } else {
+        if (ms < _min) _min = ms;
+        if (ms > _max) _max = ms;
+        _meanQ4 += ((ms << 4) - _meanQ4) / 8;
+    }
+    _last = ms;
+    _count++;
+
+    unsigned b = ms < 0 ? 0 : (unsigned)ms / BUCKET_WIDTH_MS;
+    if (b >= BUCKET_COUNT)
+        b = BUCKET_COUNT - 1;
+    // Halve everything when a bucket saturates so the shape is kept
+    if (_buckets[b] == 0xffff) {
+        for (unsigned i = 0; i < BUCKET_COUNT; i++)
+            _buckets[i] >>= 1;
+    }
+    _buckets[b]++;
+}
+
+int32_t LatencyEstimator::getP95() const {
+    uint32_t total = 0;
+    for (unsigned i = 0; i < BUCKET_COUNT; i++)
+        total += _buckets[i];
+    if (total == 0)
+        return 0;
+    // Walk down from the top until more than 5% has been seen
+    uint32_t limit = total / 20;
+    uint32_t acc = 0;
+    for (int i = BUCKET_COUNT - 1; i >= 0; i--) {
+        acc += _buckets[i];
+        if (acc > limit)
+            return (i + 1) * BUCKET_WIDTH_MS;
+    }
+    return BUCKET_WIDTH_MS;
+}
+
+}
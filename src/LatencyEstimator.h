@@ -0,0 +1,76 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace kc1fsz {
+
+/**
+ * Keeps running statistics (min, max, smoothed mean and an approximate
+ * 95th percentile) for a stream of delay measurements in milliseconds.
+ * The percentile comes from a fixed histogram so there is no allocation
+ * and the cost per sample is constant.
+ */
+class LatencyEstimator {
+public:
+
+    static const unsigned BUCKET_COUNT = 64;
+    static const unsigned BUCKET_WIDTH_MS = 5;
+
+    void reset();
+
+    /**
+     * Negative samples are allowed (i.e. one-way estimates from clocks
+     * that are slightly off) but are counted in the first bucket.
+     */
+    void addSample(int32_t ms);
+
+    uint32_t getCount() const { return _count; }
+    int32_t getMin() const { return _min; }
+    int32_t getMax() const { return _max; }
+    int32_t getLast() const { return _last; }
+
+    /**
+     * @returns Exponentially smoothed mean (about 8 samples)
+     */
+    int32_t getMean() const { return _meanQ4 >> 4; }
+
+    /**
+     * @returns The upper edge of the bucket that contains the 95th
+     * percentile. Samples beyond the histogram range are reported as
+     * the range limit.
+     */
+    int32_t getP95() const;
+
+    /**
+     * Raw histogram access, used for exporting.
+     */
+    const uint16_t* getBuckets() const { return _buckets; }
+
+private:
+
+    uint32_t _count = 0;
+    int32_t _min = 0;
+    int32_t _max = 0;
+    int32_t _last = 0;
+    int32_t _meanQ4 = 0;
+    // The last bucket also collects everything beyond the range
+    uint16_t _buckets[BUCKET_COUNT] = { 0 };
+};
+
+}
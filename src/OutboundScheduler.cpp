@@ -0,0 +1,125 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstring>
+
+#include "kc1fsz-tools/NetUtils.h"
+
+#include "OutboundScheduler.h"
+
+namespace kc1fsz {
+
+void OutboundScheduler::submit(Class c, const uint8_t* b, unsigned len,
+    const sockaddr& addr, uint32_t nowMs) {
+
+    // Audio skips the queue unless it would overtake older audio
+    if (c == AUDIO && _queues[AUDIO].count == 0) {
+        int rc = _send(b, len, addr);
+        if (rc == SEND_OK) {
+            _stats[c].sent++;
+            return;
+        }
+        else if (rc == SEND_FAILED) {
+            _stats[c].dropped++;
+            return;
+        }
+        _stats[c].busy++;
+    }
+
+    _push(c, b, len, addr, nowMs);
+}
+
+void OutboundScheduler::drain(uint32_t nowMs) {
+
+    _controlTokens += CONTROL_TOKENS_PER_TICK;
+    if (_controlTokens > CONTROL_BURST)
+        _controlTokens = CONTROL_BURST;
+
+    while (_queues[AUDIO].count)
+        if (!_sendHead(AUDIO, nowMs))
+            return;
+
+    while (_queues[CONTROL].count && _controlTokens) {
+        if (!_sendHead(CONTROL, nowMs))
+            return;
+        _controlTokens--;
+    }
+}
+
+void OutboundScheduler::clear() {
+    for (unsigned c = 0; c < CLASS_COUNT; c++) {
+        _queues[c].head = 0;
+        _queues[c].count = 0;
+    }
+}
+
+void OutboundScheduler::_push(Class c, const uint8_t* b, unsigned len,
+    const sockaddr& addr, uint32_t nowMs) {
+
+    Queue& q = _queues[c];
+
+    if (len > MAX_PACKET_SIZE) {
+        _stats[c].dropped++;
+        return;
+    }
+    if (q.count == QUEUE_DEPTH) {
+        _stats[c].dropped++;
+        if (c == AUDIO)
+            _pop(c);
+        else
+            return;
+    }
+
+    Slot& s = q.slots[(q.head + q.count) % QUEUE_DEPTH];
+    memcpy(s.data, b, len);
+    s.len = len;
+    memcpy(&s.addr, &addr, getIPAddrSize(addr));
+    s.queuedMs = nowMs;
+    q.count++;
+    _stats[c].queued++;
+}
+
+void OutboundScheduler::_pop(Class c) {
+    Queue& q = _queues[c];
+    q.head = (q.head + 1) % QUEUE_DEPTH;
+    q.count--;
+}
+
+bool OutboundScheduler::_sendHead(Class c, uint32_t nowMs) {
+
+    Slot& s = _queues[c].slots[_queues[c].head];
+
+    int rc = _send(s.data, s.len, (const sockaddr&)s.addr);
+    if (rc == SEND_BUSY) {
+        _stats[c].busy++;
+        return false;
+    }
+    else if (rc == SEND_OK) {
+        uint32_t waitMs = nowMs - s.queuedMs;
+        _stats[c].sent++;
+        _stats[c].totalQueuedMs += waitMs;
+        if (waitMs > _stats[c].maxQueuedMs)
+            _stats[c].maxQueuedMs = waitMs;
+    }
+    else {
+        _stats[c].dropped++;
+    }
+
+    _pop(c);
+    return true;
+}
+
+}
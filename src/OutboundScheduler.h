@@ -0,0 +1,119 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <sys/socket.h>
+
+#include <cstdint>
+#include <functional>
+
+namespace kc1fsz {
+
+/**
+ * A small strict-priority scheduler for outbound datagrams.
+ *
+ * Audio always goes first: it is sent immediately unless older audio is
+ * already waiting (i.e. because of back-pressure from the network stack).
+ * Control traffic (auth, keepalive, etc.) is always queued and is drained
+ * from the audio tick after the audio queue is empty, subject to a token
+ * bucket so a burst of session activity can't crowd out audio.
+ *
+ * All storage is fixed. When a queue is full audio drops its oldest
+ * packet (stale audio is worthless) and control drops the newest.
+ */
+class OutboundScheduler {
+public:
+
+    enum Class { AUDIO = 0, CONTROL = 1, CLASS_COUNT = 2 };
+
+    static const unsigned QUEUE_DEPTH = 4;
+    // Big enough for a VOTER audio frame (24 + 1 + 160)
+    static const unsigned MAX_PACKET_SIZE = 256;
+
+    // Control packets allowed per tick, and the largest burst
+    static const unsigned CONTROL_TOKENS_PER_TICK = 1;
+    static const unsigned CONTROL_BURST = 4;
+
+    // Return codes for the send function
+    static const int SEND_OK = 0;
+    static const int SEND_BUSY = 1;
+    static const int SEND_FAILED = -1;
+
+    struct Stats {
+        uint32_t sent = 0;
+        uint32_t queued = 0;
+        uint32_t dropped = 0;
+        // Sends that were refused by the network stack and retried
+        uint32_t busy = 0;
+        // Time spent waiting in the queue by packets that were sent
+        uint32_t totalQueuedMs = 0;
+        uint32_t maxQueuedMs = 0;
+    };
+
+    /**
+     * @param send Does the actual transmission. Must return SEND_OK,
+     * SEND_BUSY (try again later) or SEND_FAILED (give up on the packet).
+     */
+    void setSender(std::function<int(const uint8_t* b, unsigned len, const sockaddr& addr)> send) {
+        _send = send;
+    }
+
+    void submit(Class c, const uint8_t* b, unsigned len, const sockaddr& addr,
+        uint32_t nowMs);
+
+    /**
+     * Call from the audio tick.
+     */
+    void drain(uint32_t nowMs);
+
+    void clear();
+
+    unsigned getDepth(Class c) const { return _queues[c].count; }
+
+    const Stats& getStats(Class c) const { return _stats[c]; }
+
+private:
+
+    struct Slot {
+        uint8_t data[MAX_PACKET_SIZE];
+        unsigned len;
+        sockaddr_storage addr;
+        uint32_t queuedMs;
+    };
+
+    struct Queue {
+        Slot slots[QUEUE_DEPTH];
+        unsigned head = 0;
+        unsigned count = 0;
+    };
+
+    void _push(Class c, const uint8_t* b, unsigned len, const sockaddr& addr,
+        uint32_t nowMs);
+    void _pop(Class c);
+    /**
+     * @returns true if the head of the queue was dealt with (sent or
+     * abandoned), false if the network pushed back.
+     */
+    bool _sendHead(Class c, uint32_t nowMs);
+
+    std::function<int(const uint8_t* b, unsigned len, const sockaddr& addr)> _send;
+    Queue _queues[CLASS_COUNT];
+    Stats _stats[CLASS_COUNT];
+    unsigned _controlTokens = CONTROL_BURST;
+};
+
+}
@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+
+#include "AudioOutput.h"
+#include "PwmAudioDriver.h"
+
+namespace kc1fsz {
+
+PwmAudioDriver* PwmAudioDriver::_instance = 0;
+
+PwmAudioDriver::PwmAudioDriver(AudioOutput& source, unsigned gpioPin)
+:   _source(source),
+    _pin(gpioPin) {
+}
+
+void PwmAudioDriver::start() {
+
+    _instance = this;
+
+    gpio_set_function(_pin, GPIO_FUNC_PWM);
+    _slice = pwm_gpio_to_slice_num(_pin);
+    pwm_config cfg = pwm_get_default_config();
+    pwm_config_set_wrap(&cfg, PWM_WRAP);
+    pwm_init(_slice, &cfg, true);
+
+    // Both buffers start out silent (mid-scale)
+    _fill(0);
+    _fill(1);
+
+    // The DMA timer ticks at sys_clk * num / den
+    _timer = dma_claim_unused_timer(true);
+    dma_timer_set_fraction(_timer, 1, clock_get_hz(clk_sys) / 8000);
+
+    _dmaCh[0] = dma_claim_unused_channel(true);
+    _dmaCh[1] = dma_claim_unused_channel(true);
+
+    for (unsigned i = 0; i < 2; i++) {
+        dma_channel_config c = dma_channel_get_default_config(_dmaCh[i]);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, dma_get_timer_dreq(_timer));
+        // Each channel kicks off the other when it finishes
+        channel_config_set_chain_to(&c, _dmaCh[i ^ 1]);
+        dma_channel_configure(_dmaCh[i], &c, &pwm_hw->slice[_slice].cc,
+            _buf[i], BLOCK_SIZE, false);
+        dma_channel_set_irq0_enabled(_dmaCh[i], true);
+    }
+
+    irq_add_shared_handler(DMA_IRQ_0, _irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    dma_channel_start(_dmaCh[0]);
+}
+
+void PwmAudioDriver::_irq() {
+    PwmAudioDriver* d = _instance;
+    for (unsigned i = 0; i < 2; i++) {
+        if (dma_channel_get_irq0_status(d->_dmaCh[i])) {
+            dma_channel_acknowledge_irq0(d->_dmaCh[i]);
+            // Point the channel back at the start of its buffer now, 
+            // while the other one plays. If run2() is late the old 
+            // block is repeated instead of reading past the buffer. 
+            // (The transfer count reloads by itself.)
+            dma_channel_set_read_addr(d->_dmaCh[i], d->_buf[i], false);
+            d->_free[i] = true;
+        }
+    }
+}
+
+bool PwmAudioDriver::run2() {
+    // There's a full 20ms (while the other buffer plays) to get this done
+    for (unsigned i = 0; i < 2; i++) {
+        if (_free[i]) {
+            _free[i] = false;
+            _fill(i);
+        }
+    }
+    return false;
+}
+
+void PwmAudioDriver::_fill(unsigned block) {
+    int16_t pcm[BLOCK_SIZE];
+    _source.render(pcm, BLOCK_SIZE);
+    for (unsigned i = 0; i < BLOCK_SIZE; i++) {
+        uint32_t level = ((uint32_t)(pcm[i] + 32768) * (PWM_WRAP + 1)) >> 16;
+        // Same level on both channels of the slice
+        _buf[block][i] = (level << 16) | level;
+    }
+}
+
+}
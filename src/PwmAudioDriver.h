@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "Runnable2.h"
+
+namespace kc1fsz {
+
+class AudioOutput;
+
+/**
+ * Plays audio out of a PWM pin on the RP2040 (an RC low-pass filter is
+ * needed on the pin). Two DMA channels are chained in a ping-pong
+ * arrangement and paced at 8 kHz by a DMA timer, so the CPU only gets
+ * involved once per 20ms block to refill whichever buffer just finished.
+ * The IRQ re-arms the finished channel and run2() does the refill.
+ *
+ * Only one instance is supported because of the shared IRQ handler.
+ */
+class PwmAudioDriver : public Runnable2 {
+public:
+
+    static const unsigned BLOCK_SIZE = 160;
+    // 125 MHz / 2048 gives a ~61 kHz carrier, well above the audio band
+    static const unsigned PWM_WRAP = 2047;
+
+    PwmAudioDriver(AudioOutput& source, unsigned gpioPin);
+
+    /**
+     * Claims the hardware and starts the DMA.
+     */
+    void start();
+
+    // ----- Runnable -------------------------------------------------------
+
+    virtual bool run2();
+
+private:
+
+    static void _irq();
+    void _fill(unsigned block);
+
+    static PwmAudioDriver* _instance;
+
+    AudioOutput& _source;
+    const unsigned _pin;
+    unsigned _slice = 0;
+    int _timer = -1;
+    int _dmaCh[2] = { -1, -1 };
+    uint32_t _buf[2][BLOCK_SIZE];
+    volatile bool _free[2] = { false, false };
+};
+
+}
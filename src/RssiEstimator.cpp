@@ -0,0 +1,52 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "RssiEstimator.h"
+
+namespace kc1fsz {
+
+void RssiEstimator::update(const int16_t* pcm, unsigned len) {
+
+    // Samples are scaled down so that the sums can't overflow 32 bits
+    // for frames up to 256 samples.
+    uint32_t total = 0;
+    uint32_t hf = 0;
+    int32_t last = _last;
+    for (unsigned i = 0; i < len; i++) {
+        int32_t x = pcm[i] >> 5;
+        int32_t d = (pcm[i] - last) >> 5;
+        total += x * x;
+        hf += d * d;
+        last = pcm[i];
+    }
+    _last = last;
+
+    // White noise gives hf/total = 2, a clean low-frequency signal gives
+    // something close to 0. Map [0, 2] onto [255, 0].
+    uint32_t target;
+    if (total == 0)
+        target = 0;
+    else if (hf >= 2 * total)
+        target = 0;
+    else
+        target = 255 - (uint32_t)(((uint64_t)hf * 255) / (2 * (uint64_t)total));
+
+    // Smooth over roughly 8 frames
+    int32_t err = (int32_t)(target << 8) - (int32_t)_smoothed;
+    _smoothed = (uint32_t)((int32_t)_smoothed + err / 8);
+}
+
+}
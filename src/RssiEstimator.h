@@ -0,0 +1,55 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace kc1fsz {
+
+/**
+ * Estimates the received signal strength from discriminator audio. A
+ * weak FM signal produces audio dominated by high-frequency noise, so
+ * the ratio of the first-difference energy (a crude high-pass) to the
+ * total energy is used as a noise figure. The result is smoothed and
+ * mapped onto the 0-255 range used by the VOTER protocol.
+ *
+ * Integer-only, no allocation.
+ */
+class RssiEstimator {
+public:
+
+    /**
+     * Call once per frame with the linear PCM audio.
+     */
+    void update(const int16_t* pcm, unsigned len);
+
+    /**
+     * Forces a fixed value. Use 0 to go back to estimating.
+     */
+    void setOverride(uint8_t rssi) { _override = rssi; }
+
+    uint8_t getRssi() const { return _override ? _override : (uint8_t)(_smoothed >> 8); }
+
+private:
+
+    uint8_t _override = 0;
+    // 8.8 fixed point
+    uint32_t _smoothed = 0;
+    int16_t _last = 0;
+};
+
+}
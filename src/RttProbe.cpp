@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "VoterProto.h"
+#include "RttProbe.h"
+
+namespace kc1fsz {
+
+unsigned RttProbe::makeProbe(uint32_t nowMs, uint8_t* payload) {
+    if (isPending(nowMs))
+        return 0;
+    _seq++;
+    _stampMs = nowMs;
+    _built = true;
+    _sent = false;
+    voter::pack32(payload, _seq);
+    voter::pack32(payload + 4, _stampMs);
+    return PAYLOAD_SIZE;
+}
+
+void RttProbe::sent(const uint8_t* payload, unsigned payloadLen, uint32_t nowMs) {
+    if (_built && !_sent && _matches(payload, payloadLen)) {
+        _sent = true;
+        _txMs = nowMs;
+    }
+}
+
+bool RttProbe::isReply(const uint8_t* payload, unsigned payloadLen, uint32_t rxMs,
+    uint32_t& rttMs) {
+    if (!_sent || !_matches(payload, payloadLen))
+        return false;
+    _built = false;
+    _sent = false;
+    if (rxMs - _txMs >= TIMEOUT_MS)
+        return false;
+    rttMs = rxMs - _txMs;
+    return true;
+}
+
+bool RttProbe::isPending(uint32_t nowMs) const {
+    if (!_built)
+        return false;
+    // A probe that never went out (i.e. dropped by the scheduler) is 
+    // given up on at the same time as a lost one
+    return nowMs - (_sent ? _txMs : _stampMs) < TIMEOUT_MS;
+}
+
+bool RttProbe::_matches(const uint8_t* payload, unsigned payloadLen) const {
+    return payloadLen == PAYLOAD_SIZE && voter::unpack32(payload) == _seq &&
+        voter::unpack32(payload + 4) == _stampMs;
+}
+
+}
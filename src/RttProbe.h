@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace kc1fsz {
+
+/**
+ * Round trip measurement with VOTER ping packets (PAYLOAD_PING). The 
+ * payload carries a sequence number and the send time, and the server
+ * echoes it back, so the reply can't be confused with a keepalive that
+ * crossed the probe, and a late reply to an earlier probe (i.e. after 
+ * one was lost) doesn't match the current one. One probe is outstanding
+ * at a time.
+ */
+class RttProbe {
+public:
+
+    static const unsigned PAYLOAD_SIZE = 8;
+    // Any probe that takes longer than this is considered lost
+    static const uint32_t TIMEOUT_MS = 1000;
+
+    /**
+     * Builds the payload of the next probe. 
+     *
+     * @returns PAYLOAD_SIZE, or 0 if the last probe is still waiting 
+     * for its reply.
+     */
+    unsigned makeProbe(uint32_t nowMs, uint8_t* payload);
+
+    /**
+     * Called when a ping payload actually goes out. The timing starts 
+     * here rather than in makeProbe() since the send can be queued.
+     */
+    void sent(const uint8_t* payload, unsigned payloadLen, uint32_t nowMs);
+
+    /**
+     * Checks an inbound ping payload against the outstanding probe.
+     *
+     * @param rttMs Set to the round trip if this is the reply.
+     * @returns true if this is the reply.
+     */
+    bool isReply(const uint8_t* payload, unsigned payloadLen, uint32_t rxMs,
+        uint32_t& rttMs);
+
+    bool isPending(uint32_t nowMs) const;
+
+private:
+
+    bool _matches(const uint8_t* payload, unsigned payloadLen) const;
+
+    uint32_t _seq = 0;
+    uint32_t _stampMs = 0;
+    bool _built = false;
+    bool _sent = false;
+    uint32_t _txMs = 0;
+};
+
+}
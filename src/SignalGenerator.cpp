@@ -24,13 +24,13 @@
 namespace kc1fsz {
 
 SignalGenerator::SignalGenerator(Log& log, Clock& clock, unsigned lineId, 
-    MessageConsumer& bus, unsigned destLineId) 
+    MessageConsumer& bus, unsigned destLineId, float freqHz) 
 :   _log(log),
     _clock(clock),
     _lineId(lineId),
     _bus(bus),
     _destLineId(destLineId) {
-    _omega = 400.0f * 2.0f * 3.1415926f / 8000.0f;
+    _omega = freqHz * 2.0f * 3.1415926f / 8000.0f;
 }
 
 void SignalGenerator::consume(const Message& m) {    
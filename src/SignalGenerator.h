@@ -42,7 +42,7 @@ public:
      * de-jittered before they are passed to this sink. 
      */
     SignalGenerator(Log& log, Clock& clock, unsigned lineId, MessageConsumer& consumer,
-        unsigned destLineId);
+        unsigned destLineId, float freqHz = 400.0f);
    
     // ----- Line/MessageConsumer-----------------------------------------------------
 
@@ -0,0 +1,93 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "kc1fsz-tools/Log.h"
+
+#include "simnet.h"
+#include "SimClock.h"
+#include "SimEventLoop.h"
+
+namespace kc1fsz {
+
+SimEventLoop::SimEventLoop(Log& log, SimClock& clock, Runnable2** tasks, 
+    unsigned taskCount)
+:   _log(log),
+    _clock(clock),
+    _tasks(tasks),
+    _taskCount(taskCount),
+    _nextTickMs(clock.time() + AUDIO_TICK_MS) {
+}
+
+void SimEventLoop::runFor(uint32_t durationMs) {
+    runUntil(_clock.time() + durationMs);
+}
+
+void SimEventLoop::runUntil(uint32_t endMs) {
+
+    while ((int32_t)(endMs - _clock.time()) > 0) {
+
+        // Jump to whatever happens first
+        uint32_t next = _nextTickMs;
+        if ((int32_t)(endMs - next) < 0)
+            next = endMs;
+        if ((int32_t)(next - (_clock.time() + _maxStepMs)) > 0)
+            next = _clock.time() + _maxStepMs;
+        next = simnet_next_delivery(next);
+        _clock.set(next);
+        _stats.events++;
+
+        simnet_advance(next);
+        _runTasks();
+
+        if (next == _nextTickMs) {
+            _tick(next);
+            _nextTickMs += AUDIO_TICK_MS;
+            // Let the tasks react to the tick (i.e. send what was queued)
+            _runTasks();
+        }
+    }
+}
+
+void SimEventLoop::_runTasks() {
+    for (unsigned pass = 0; pass < MAX_RUN_PASSES; pass++) {
+        bool busy = false;
+        for (unsigned i = 0; i < _taskCount; i++) {
+            _stats.run2Calls++;
+            if (_tasks[i]->run2())
+                busy = true;
+        }
+        if (!busy)
+            return;
+    }
+    if (_stats.busyLimitHits++ == 0)
+        _log.error("Task still busy after %u passes at %u ms", MAX_RUN_PASSES,
+            _clock.time());
+}
+
+void SimEventLoop::_tick(uint32_t tickMs) {
+    _stats.audioTicks++;
+    for (unsigned i = 0; i < _taskCount; i++)
+        _tasks[i]->audioRateTick(tickMs);
+    _tickCount++;
+    if (_tickCount % (1000 / AUDIO_TICK_MS) == 0)
+        for (unsigned i = 0; i < _taskCount; i++)
+            _tasks[i]->oneSecTick();
+    if (_tickCount % (10000 / AUDIO_TICK_MS) == 0)
+        for (unsigned i = 0; i < _taskCount; i++)
+            _tasks[i]->tenSecTick();
+}
+
+}
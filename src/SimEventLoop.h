@@ -0,0 +1,89 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "Runnable2.h"
+
+namespace kc1fsz {
+
+class Log;
+class SimClock;
+
+/**
+ * The host stand-in for the PicoEventLoop. Rather than spinning in 
+ * real time it jumps the SimClock from one event to the next, where an
+ * event is either an audio tick or the arrival of a packet on the
+ * simulated network (see micro-ip/impl-sim). The one and ten second
+ * ticks are derived from the audio ticks, so everything happens in the
+ * same order on every run.
+ *
+ * Tasks see run2() after every event until they report that they are
+ * idle. Anything a task does in run2() based on elapsed time therefore
+ * has the resolution of an audio tick, unless setMaxStepMs() is used.
+ */
+class SimEventLoop {
+public:
+
+    static const uint32_t AUDIO_TICK_MS = 20;
+    // Guards against a task that always claims to have more work
+    static const unsigned MAX_RUN_PASSES = 64;
+
+    struct Stats {
+        uint32_t events = 0;
+        uint32_t audioTicks = 0;
+        uint32_t run2Calls = 0;
+        // Events where a task was still busy after MAX_RUN_PASSES
+        uint32_t busyLimitHits = 0;
+    };
+
+    SimEventLoop(Log& log, SimClock& clock, Runnable2** tasks, unsigned taskCount);
+
+    /**
+     * Runs until the clock reaches the given (absolute) time.
+     */
+    void runUntil(uint32_t endMs);
+
+    void runFor(uint32_t durationMs);
+
+    /**
+     * Makes sure that the tasks are run at least this often, even when
+     * nothing is happening. Needed for tasks that keep their own 
+     * schedule in run2() (i.e. the TickAligner). Default is the audio
+     * tick.
+     */
+    void setMaxStepMs(uint32_t ms) { _maxStepMs = ms ? ms : 1; }
+
+    const Stats& getStats() const { return _stats; }
+
+private:
+
+    void _runTasks();
+    void _tick(uint32_t tickMs);
+
+    Log& _log;
+    SimClock& _clock;
+    Runnable2** _tasks;
+    const unsigned _taskCount;
+    uint32_t _nextTickMs;
+    uint32_t _maxStepMs = AUDIO_TICK_MS;
+    unsigned _tickCount = 0;
+    Stats _stats;
+};
+
+}
@@ -0,0 +1,259 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/Clock.h"
+#include "kc1fsz-tools/NetUtils.h"
+
+// amp-core
+#include "Transcoder_G711_ULAW.h"
+
+#include "VoterProto.h"
+#include "SimVoterServer.h"
+
+namespace kc1fsz {
+
+static void pack32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void pack16(uint8_t* p, uint16_t v) {
+    p[0] = v >> 8;
+    p[1] = v;
+}
+
+SimVoterServer::SimVoterServer(Log& log, Clock& clock)
+:   _log(log),
+    _clock(clock) {
+    _serverPassword[0] = 0;
+    _newChallenge();
+    // A 1 kHz tone at -10 dBFS, which is an exact number of cycles
+    // per frame
+    int16_t pcm[160];
+    for (unsigned i = 0; i < 160; i++)
+        pcm[i] = (int16_t)(10362.0 * std::sin(2.0 * 3.14159265358979 * i / 8.0));
+    Transcoder_G711_ULAW tc;
+    tc.encode(pcm, 160, _downlinkFrame, 160);
+    Transcoder_IMA_ADPCM adpcm;
+    adpcm.encode(pcm, 160, _downlinkAdpcmFrame, sizeof(_downlinkAdpcmFrame));
+}
+
+int SimVoterServer::open(const char* addrAndPort) {
+
+    close();
+
+    sockaddr_storage addr;
+    if (parseIPAddrAndPort(addrAndPort, addr) != 0)
+        return -1;
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        _log.error("Unable to open server socket (%d)", errno);
+        return -1;
+    }
+    if (::bind(fd, (const sockaddr*)&addr, sizeof(sockaddr_in)) != 0) {
+        _log.error("Unable to bind server socket (%d)", errno);
+        ::close(fd);
+        return -1;
+    }
+    _sockFd = fd;
+    return 0;
+}
+
+void SimVoterServer::close() {
+    if (_sockFd)
+        ::close(_sockFd);
+    _sockFd = 0;
+}
+
+void SimVoterServer::setSeed(uint32_t seed) {
+    _rand = seed ? seed : 1;
+    _newChallenge();
+}
+
+void SimVoterServer::setServerPassword(const char* p) {
+    strncpy(_serverPassword, p, sizeof(_serverPassword) - 1);
+    _serverPassword[sizeof(_serverPassword) - 1] = 0;
+}
+
+int SimVoterServer::addClientPassword(const char* p) {
+    if (_clientPasswordCount == MAX_CLIENTS)
+        return -1;
+    char* d = _clientPasswords[_clientPasswordCount++];
+    strncpy(d, p, sizeof(_clientPasswords[0]) - 1);
+    d[sizeof(_clientPasswords[0]) - 1] = 0;
+    _updateDigests();
+    return 0;
+}
+
+void SimVoterServer::restart() {
+    _newChallenge();
+    for (unsigned i = 0; i < MAX_CLIENTS; i++) {
+        _sessions[i].active = false;
+        _sessions[i].authenticated = false;
+    }
+    _log.info("Server restarted with challenge %s", _challenge);
+}
+
+void SimVoterServer::_newChallenge() {
+    _rand ^= _rand << 13;
+    _rand ^= _rand >> 17;
+    _rand ^= _rand << 5;
+    snprintf(_challenge, sizeof(_challenge), "%010u", (unsigned)(_rand % 1000000000));
+    _updateDigests();
+}
+
+void SimVoterServer::_updateDigests() {
+    for (unsigned i = 0; i < _clientPasswordCount; i++)
+        _clientDigests[i] = voter::crc32(_challenge, _clientPasswords[i]);
+}
+
+bool SimVoterServer::run2() {
+    if (!_sockFd)
+        return false;
+    uint8_t buf[512];
+    sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    int rc = ::recvfrom(_sockFd, buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+    if (rc <= 0)
+        return false;
+    _process(buf, rc, from);
+    return true;
+}
+
+void SimVoterServer::_process(const uint8_t* packet, unsigned len, 
+    const sockaddr_in& from) {
+
+    if (!voter::isValidHeader(packet, len))
+        return;
+
+    char challenge[voter::CHALLENGE_SIZE + 1];
+    memcpy(challenge, packet + voter::OFFSET_CHALLENGE, voter::CHALLENGE_SIZE);
+    challenge[voter::CHALLENGE_SIZE] = 0;
+    const uint32_t reply = voter::crc32(challenge, _serverPassword);
+
+    // The digest says which client this is
+    const uint32_t digest = voter::getDigest(packet);
+    Session* s = 0;
+    for (unsigned i = 0; i < _clientPasswordCount && !s; i++)
+        if (digest == _clientDigests[i])
+            s = &_sessions[i];
+
+    if (!s) {
+        if (digest != 0)
+            _badDigestCount++;
+        // The auth response goes back to wherever this came from 
+        Session anon;
+        anon.addr = from;
+        _send(anon, reply, voter::PAYLOAD_NONE, 0, 0);
+        return;
+    }
+
+    if (!s->active) {
+        const uint32_t authCount = s->authCount;
+        *s = Session();
+        s->active = true;
+        s->authenticated = true;
+        s->authCount = authCount + 1;
+    }
+    // The client may have moved
+    s->addr = from;
+    s->lastRxMs = _clock.time();
+    memcpy(s->clientChallenge, challenge, sizeof(challenge));
+
+    uint16_t pt = voter::getPayloadType(packet);
+    if (pt == voter::PAYLOAD_ULAW || pt == voter::PAYLOAD_NULAW || 
+        pt == voter::PAYLOAD_ADPCM) {
+        // The client should be stamping in our timebase
+        const uint32_t now = _clock.time() + _clockOffsetMs;
+        const int32_t lag = (int32_t)(now - (uint32_t)voter::getTimeMs(packet));
+        if (s->uplinkFrames == 0 || lag < s->stampLagMinMs)
+            s->stampLagMinMs = lag;
+        if (s->uplinkFrames == 0 || lag > s->stampLagMaxMs)
+            s->stampLagMaxMs = lag;
+        s->uplinkFrames++;
+        if (pt == voter::PAYLOAD_ADPCM)
+            s->uplinkAdpcmFrames++;
+    }
+    else if (pt == voter::PAYLOAD_NONE)
+        _send(*s, reply, voter::PAYLOAD_NONE, 0, 0);
+    // Pings are echoed
+    else if (pt == voter::PAYLOAD_PING)
+        _send(*s, reply, voter::PAYLOAD_PING, packet + voter::HEADER_SIZE, 
+            len - voter::HEADER_SIZE);
+}
+
+void SimVoterServer::_send(Session& s, uint32_t digest, uint16_t payloadType, 
+    const uint8_t* payload, unsigned payloadLen) {
+    uint8_t packet[voter::HEADER_SIZE + 160];
+    const uint32_t now = _clock.time() + _clockOffsetMs;
+    memset(packet, 0, voter::HEADER_SIZE);
+    pack32(packet + voter::OFFSET_SEC, now / 1000);
+    pack32(packet + voter::OFFSET_NSEC, (now % 1000) * 1000000);
+    memcpy(packet + voter::OFFSET_CHALLENGE, _challenge, voter::CHALLENGE_SIZE);
+    pack32(packet + voter::OFFSET_DIGEST, digest);
+    pack16(packet + voter::OFFSET_PAYLOAD_TYPE, payloadType);
+    if (payloadLen > 160)
+        payloadLen = 160;
+    if (payloadLen)
+        memcpy(packet + voter::HEADER_SIZE, payload, payloadLen);
+    ::sendto(_sockFd, packet, voter::HEADER_SIZE + payloadLen, 0, 
+        (const sockaddr*)&s.addr, sizeof(s.addr));
+}
+
+void SimVoterServer::audioRateTick(uint32_t tickTimeMs) {
+    if (!_downlinkOn)
+        return;
+    for (unsigned i = 0; i < MAX_CLIENTS; i++) {
+        Session& s = _sessions[i];
+        if (s.active && s.authenticated)
+            _send(s, voter::crc32(s.clientChallenge, _serverPassword), 
+                _downlinkAdpcm ? voter::PAYLOAD_ADPCM : voter::PAYLOAD_ULAW, 
+                _downlinkAdpcm ? _downlinkAdpcmFrame : _downlinkFrame,
+                _downlinkAdpcm ? sizeof(_downlinkAdpcmFrame) : sizeof(_downlinkFrame));
+    }
+}
+
+void SimVoterServer::oneSecTick() {
+    const uint32_t now = _clock.time();
+    for (unsigned i = 0; i < MAX_CLIENTS; i++) {
+        Session& s = _sessions[i];
+        if (!s.active)
+            continue;
+        if (now - s.lastRxMs > SESSION_TIMEOUT_MS) {
+            _log.info("Server dropped session %u", i);
+            s.active = false;
+            s.authenticated = false;
+            continue;
+        }
+        // Keepalive
+        _send(s, voter::crc32(s.clientChallenge, _serverPassword), 
+            voter::PAYLOAD_NONE, 0, 0);
+    }
+}
+
+}
@@ -0,0 +1,147 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <netinet/in.h>
+
+#include "Runnable2.h"
+#include "Transcoder_IMA_ADPCM.h"
+
+namespace kc1fsz {
+
+class Log;
+class Clock;
+
+/**
+ * Just enough of a VOTER server to exercise the client in simulation:
+ *
+ * - Answers packets that don't carry a valid client digest with its own
+ *   challenge and the digest of the client's challenge + server password.
+ * - Accepts packets signed with any of the registered client passwords,
+ *   counting uplink audio. Like a real server, clients are told apart by
+ *   the password that signed the packet (there is one session per 
+ *   password) rather than by address, since several lines can share a
+ *   socket.
+ * - Answers payload-less packets right away, echoes pings (so RTT can
+ *   be measured), sends a keepalive every second and optionally a 
+ *   downlink tone on every audio tick. The keepalives can cross the 
+ *   client's probes, as they do with a real server.
+ * - Forgets sessions that go quiet, and can be restarted with a new
+ *   challenge to force every client to authenticate again.
+ */
+class SimVoterServer : public Runnable2 {
+public:
+
+    // One session per client password
+    static const unsigned MAX_CLIENTS = 4;
+    static const uint32_t SESSION_TIMEOUT_MS = 5000;
+
+    struct Session {
+        bool active = false;
+        bool authenticated = false;
+        sockaddr_in addr;
+        char clientChallenge[11];
+        uint32_t lastRxMs = 0;
+        // Number of times this session went from unauthenticated to 
+        // authenticated
+        uint32_t authCount = 0;
+        uint32_t uplinkFrames = 0;
+        uint32_t uplinkAdpcmFrames = 0;
+        // Server time at arrival minus the time stamp on the client's 
+        // audio frames, smallest and largest
+        int32_t stampLagMinMs = 0;
+        int32_t stampLagMaxMs = 0;
+    };
+
+    SimVoterServer(Log& log, Clock& clock);
+
+    /**
+     * Opens the socket and binds it to the given address.
+     * @returns 0 on success
+     */
+    int open(const char* addrAndPort);
+
+    void close();
+
+    void setSeed(uint32_t seed);
+    void setServerPassword(const char* p);
+
+    /**
+     * @returns 0 on success, -1 if the table is full
+     */
+    int addClientPassword(const char* p);
+
+    void setDownlinkAudio(bool on) { _downlinkOn = on; }
+
+    /**
+     * Sends the downlink as ADPCM rather than u-law.
+     */
+    void setDownlinkAdpcm(bool on) { _downlinkAdpcm = on; }
+
+    /**
+     * The server's time stamps are the shared clock plus this offset.
+     */
+    void setClockOffset(int32_t ms) { _clockOffsetMs = ms; }
+
+    /**
+     * Picks a new challenge and drops every session.
+     */
+    void restart();
+
+    const Session& getSession(unsigned i) const { return _sessions[i]; }
+
+    /**
+     * @returns The number of packets signed with a digest that didn't
+     * match any client password.
+     */
+    uint32_t getBadDigestCount() const { return _badDigestCount; }
+
+    // ----- Runnable -------------------------------------------------------
+
+    virtual bool run2();
+    virtual void audioRateTick(uint32_t tickTimeMs);
+    virtual void oneSecTick();
+
+private:
+
+    void _newChallenge();
+    void _updateDigests();
+    void _process(const uint8_t* packet, unsigned len, const sockaddr_in& from);
+    void _send(Session& s, uint32_t digest, uint16_t payloadType, 
+        const uint8_t* payload, unsigned payloadLen);
+
+    Log& _log;
+    Clock& _clock;
+    int _sockFd = 0;
+    uint32_t _rand = 1;
+    char _challenge[11];
+    char _serverPassword[32];
+    char _clientPasswords[MAX_CLIENTS][32];
+    // The digest each client puts on its packets for the current challenge
+    uint32_t _clientDigests[MAX_CLIENTS];
+    unsigned _clientPasswordCount = 0;
+    Session _sessions[MAX_CLIENTS];
+    uint32_t _badDigestCount = 0;
+    bool _downlinkOn = false;
+    int32_t _clockOffsetMs = 0;
+    bool _downlinkAdpcm = false;
+    uint8_t _downlinkFrame[160];
+    uint8_t _downlinkAdpcmFrame[Transcoder_IMA_ADPCM::FRAME_SIZE];
+};
+
+}
@@ -0,0 +1,150 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+#include "Runnable2.h"
+
+namespace kc1fsz {
+
+/**
+ * A fixed group of tasks whose types are known at compile time. Each
+ * Runnable2 hook is only called on the tasks that actually override it,
+ * and the calls are qualified (non-virtual) so they can be inlined. The
+ * group is itself a Runnable2, so the event loop makes one virtual call
+ * per hook for the whole group instead of one per task:
+ *
+ *     StaticTaskGraph graph(mux, audioOut, pwmOut, dlog);
+ *     Runnable2* tasks2[] = { &graph };
+ *
+ * The tasks are called in the order given, the same as an array.
+ *
+ * IMPORTANT: The types are taken from the constructor arguments, so pass
+ * each task as its most-derived type. A task passed through a base class
+ * reference would have its own overrides skipped.
+ */
+template<typename... Tasks>
+class StaticTaskGraph : public Runnable2 {
+public:
+
+    static_assert((std::is_base_of_v<Runnable2, Tasks> && ...),
+        "StaticTaskGraph tasks must be Runnable2s");
+
+    // A hook counts as implemented when the type (or a base between it
+    // and Runnable2) declares it, which shows up as the class of the
+    // member function pointer.
+    template<typename T> static constexpr bool HAS_RUN2 =
+        !std::is_same_v<decltype(&T::run2), decltype(&Runnable2::run2)>;
+    template<typename T> static constexpr bool HAS_AUDIO_TICK =
+        !std::is_same_v<decltype(&T::audioRateTick), decltype(&Runnable2::audioRateTick)>;
+    template<typename T> static constexpr bool HAS_ONE_SEC_TICK =
+        !std::is_same_v<decltype(&T::oneSecTick), decltype(&Runnable2::oneSecTick)>;
+    template<typename T> static constexpr bool HAS_TEN_SEC_TICK =
+        !std::is_same_v<decltype(&T::tenSecTick), decltype(&Runnable2::tenSecTick)>;
+    template<typename T> static constexpr bool HAS_POLLS =
+        !std::is_same_v<decltype(&T::getPolls), decltype(&Runnable2::getPolls)>;
+
+    static constexpr unsigned TASK_COUNT = sizeof...(Tasks);
+    // The hook calls actually made, per pass of each kind
+    static constexpr unsigned RUN2_CALLS = (0 + ... + HAS_RUN2<Tasks>);
+    static constexpr unsigned AUDIO_TICK_CALLS = (0 + ... + HAS_AUDIO_TICK<Tasks>);
+    static constexpr unsigned ONE_SEC_TICK_CALLS = (0 + ... + HAS_ONE_SEC_TICK<Tasks>);
+    static constexpr unsigned TEN_SEC_TICK_CALLS = (0 + ... + HAS_TEN_SEC_TICK<Tasks>);
+    static constexpr unsigned POLLS_CALLS = (0 + ... + HAS_POLLS<Tasks>);
+
+    StaticTaskGraph(Tasks&... tasks)
+    :   _tasks(tasks...) {
+    }
+
+    // ----- Runnable -------------------------------------------------------
+
+    virtual bool run2() {
+        return std::apply([](Tasks&... t) {
+            bool busy = false;
+            // Every task runs, even after one reports that it is busy
+            ((busy = _run2(t) || busy), ...);
+            return busy;
+        }, _tasks);
+    }
+
+    virtual void audioRateTick(uint32_t tickTimeMs) {
+        std::apply([tickTimeMs](Tasks&... t) {
+            (_audioRateTick(t, tickTimeMs), ...);
+        }, _tasks);
+    }
+
+    virtual void oneSecTick() {
+        std::apply([](Tasks&... t) { (_oneSecTick(t), ...); }, _tasks);
+    }
+
+    virtual void tenSecTick() {
+        std::apply([](Tasks&... t) { (_tenSecTick(t), ...); }, _tasks);
+    }
+
+    virtual int getPolls(pollfd* fds, unsigned fdsCapacity) {
+        return std::apply([fds, fdsCapacity](Tasks&... t) {
+            int used = 0;
+            ((used += _getPolls(t, fds + used, fdsCapacity - used)), ...);
+            return used;
+        }, _tasks);
+    }
+
+private:
+
+    template<typename T>
+    static bool _run2(T& t) {
+        if constexpr (HAS_RUN2<T>)
+            return t.T::run2();
+        else
+            return false;
+    }
+
+    template<typename T>
+    static void _audioRateTick(T& t, uint32_t tickTimeMs) {
+        if constexpr (HAS_AUDIO_TICK<T>)
+            t.T::audioRateTick(tickTimeMs);
+    }
+
+    template<typename T>
+    static void _oneSecTick(T& t) {
+        if constexpr (HAS_ONE_SEC_TICK<T>)
+            t.T::oneSecTick();
+    }
+
+    template<typename T>
+    static void _tenSecTick(T& t) {
+        if constexpr (HAS_TEN_SEC_TICK<T>)
+            t.T::tenSecTick();
+    }
+
+    template<typename T>
+    static int _getPolls(T& t, pollfd* fds, unsigned fdsCapacity) {
+        if constexpr (HAS_POLLS<T>) {
+            int rc = t.T::getPolls(fds, fdsCapacity);
+            return rc > 0 ? rc : 0;
+        }
+        else
+            return 0;
+    }
+
+    std::tuple<Tasks&...> _tasks;
+};
+
+}
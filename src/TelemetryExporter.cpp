@@ -0,0 +1,239 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PICO_BOARD
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <cstring>
+#include <algorithm>
+
+#include "kc1fsz-tools/Common.h"
+#include "kc1fsz-tools/NetUtils.h"
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/Clock.h"
+
+#include "VoterClient.h"
+#include "VoterMux.h"
+#include "TickAligner.h"
+#include "DeferredLog.h"
+#include "TelemetryExporter.h"
+
+namespace kc1fsz {
+
+static_assert(telemetry::MAX_LINES >= VoterMux::MAX_LINES, 
+    "Telemetry records must have room for every line");
+
+// The nominal audio tick
+static const uint32_t TICK_MS = 20;
+
+static uint16_t clamp16(int32_t v) {
+    return (uint16_t)std::clamp(v, (int32_t)0, (int32_t)0xffff);
+}
+
+TelemetryExporter::TelemetryExporter(Log& log, Clock& clock)
+:   _log(log),
+    _clock(clock) {
+}
+
+int TelemetryExporter::open(const char* collectorAddrAndPort) {
+
+    close();
+
+    if (parseIPAddrAndPort(collectorAddrAndPort, _collectorAddr) != 0) {
+        _log.error("Bad telemetry collector address %s", collectorAddrAndPort);
+        return -1;
+    }
+
+    int sockFd = socket(_collectorAddr.ss_family, SOCK_DGRAM, 0);
+    if (sockFd < 0) {
+        _log.error("Unable to open telemetry port (%d)", errno);
+        return -1;
+    }
+
+    if (makeNonBlocking(sockFd) != 0) {
+        _log.error("open fcntl failed (%d)", errno);
+        ::close(sockFd);
+        return -1;
+    }
+
+    _sockFd = sockFd;
+    _log.info("Sending telemetry to %s every %u s as %s", collectorAddrAndPort,
+        _intervalSec, _nodeId[0] ? _nodeId : "(no node id)");
+    return 0;
+}
+
+void TelemetryExporter::close() {
+    if (_sockFd)
+        ::close(_sockFd);
+    _sockFd = 0;
+}
+
+void TelemetryExporter::setNodeId(const char* id) {
+    strncpy(_nodeId, id, telemetry::NODE_ID_SIZE);
+    _nodeId[telemetry::NODE_ID_SIZE] = 0;
+}
+
+int TelemetryExporter::addLine(const VoterClient* line) {
+    if (_lineCount == telemetry::MAX_LINES)
+        return -1;
+    _lines[_lineCount++] = line;
+    return 0;
+}
+
+void TelemetryExporter::snapshot(telemetry::Snapshot& s) const {
+
+    s = telemetry::Snapshot();
+    memcpy(s.nodeId, _nodeId, sizeof(s.nodeId));
+    s.lineCount = _lineCount;
+    s.sequence = _sequence;
+    s.uptimeSec = _uptimeSec;
+    s.intervalSec = _intervalSec;
+    s.maxTickGapMs = clamp16(_maxTickGapMs);
+    s.loopPasses = _loopPasses;
+    s.audioTicks = _audioTicks;
+    for (unsigned i = 0; i < telemetry::TICK_HIST_BUCKETS; i++)
+        s.tickHist[i] = _tickHist[i];
+
+    if (_aligner) {
+        s.flags |= telemetry::FLAG_ALIGNED;
+        if (_aligner->isLocked())
+            s.flags |= telemetry::FLAG_LOCKED;
+        s.phaseErrorMs = _aligner->getPhaseErrorMs();
+    }
+    if (_dlog)
+        s.logOverflows = _dlog->getOverflowCount();
+    if (_netSource)
+        _netSource(s.net);
+
+    for (unsigned i = 0; i < _lineCount; i++) {
+        const VoterClient& c = *(_lines[i]);
+        telemetry::LineStats& l = s.lines[i];
+        const LatencyEstimator& rtt = c.getRttStats();
+        const OutboundScheduler::Stats& sa =
+            c.getScheduler().getStats(OutboundScheduler::AUDIO);
+        const OutboundScheduler::Stats& sc =
+            c.getScheduler().getStats(OutboundScheduler::CONTROL);
+
+        l.lineId = c.getLineId();
+        if (c.isUplinkAdpcm())
+            l.flags |= telemetry::LINE_FLAG_ADPCM;
+        l.rssi = c.getRssiEstimator().getRssi();
+        if (rtt.getCount()) {
+            l.rttMinMs = clamp16(rtt.getMin());
+            l.rttMeanMs = clamp16(rtt.getMean());
+            l.rttP95Ms = clamp16(rtt.getP95());
+            l.rttMaxMs = clamp16(rtt.getMax());
+        }
+        l.rttCount = rtt.getCount();
+        l.authRejects = c.getAuthRejectCount();
+        l.audioSent = sa.sent;
+        l.audioDropped = sa.dropped;
+        l.audioBusy = sa.busy;
+        l.audioMaxQueuedMs = clamp16(sa.maxQueuedMs);
+        l.controlSent = sc.sent;
+        l.controlDropped = sc.dropped;
+
+        // Fold the fine histogram into the exported one
+        const unsigned fold = telemetry::RTT_HIST_WIDTH_MS /
+            LatencyEstimator::BUCKET_WIDTH_MS;
+        const uint16_t* b = rtt.getBuckets();
+        for (unsigned k = 0; k < LatencyEstimator::BUCKET_COUNT; k++) {
+            const unsigned t = std::min(k / fold, telemetry::RTT_HIST_BUCKETS - 1);
+            l.rttHist[t] = clamp16((int32_t)l.rttHist[t] + b[k]);
+        }
+    }
+}
+
+bool TelemetryExporter::_audioPending() const {
+    for (unsigned i = 0; i < _lineCount; i++)
+        if (_lines[i]->getScheduler().getDepth(OutboundScheduler::AUDIO))
+            return true;
+    return false;
+}
+
+void TelemetryExporter::_send() {
+
+    telemetry::Snapshot s;
+    snapshot(s);
+    uint8_t buf[telemetry::RECORD_SIZE];
+    const unsigned len = telemetry::encode(s, buf, sizeof(buf));
+
+    const sockaddr& addr = (const sockaddr&)_collectorAddr;
+    int rc = ::sendto(_sockFd, buf, len, 0, &addr, getIPAddrSize(addr));
+    if (rc < 0)
+        _sendErrorCount++;
+    else
+        _sentCount++;
+
+    _sequence++;
+    _maxTickGapMs = 0;
+}
+
+bool TelemetryExporter::run2() {
+    _loopPasses++;
+    if (_sendDue && _sockFd) {
+        if (!_audioPending()) {
+            _sendDue = false;
+            _send();
+        } else if (_deferredSec >= _intervalSec) {
+            _sendDue = false;
+            _forcedSendCount++;
+            _send();
+        }
+    }
+    return false;
+}
+
+void TelemetryExporter::audioRateTick(uint32_t) {
+    // The actual time is used (not the scheduled one) since lateness
+    // is what's being measured
+    const uint32_t now = _clock.time();
+    if (_lastTickValid) {
+        const uint32_t gap = now - _lastTickMs;
+        _tickHist[telemetry::tickBucket(gap > TICK_MS ? gap - TICK_MS : 0)]++;
+        if (gap > _maxTickGapMs)
+            _maxTickGapMs = gap;
+    }
+    _lastTickMs = now;
+    _lastTickValid = true;
+    _audioTicks++;
+}
+
+void TelemetryExporter::oneSecTick() {
+    _uptimeSec++;
+    if (_sendDue)
+        _deferredSec++;
+    if (++_secCount >= _intervalSec) {
+        _secCount = 0;
+        if (!_sendDue)
+            _deferredSec = 0;
+        _sendDue = true;
+    }
+}
+
+void TelemetryExporter::tenSecTick() {
+    const uint32_t passes = _loopPasses - _reportedLoopPasses;
+    _reportedLoopPasses = _loopPasses;
+    _log.info("Event loop %u passes/s", (unsigned)(passes / 10));
+}
+
+}
@@ -0,0 +1,158 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <netinet/in.h>
+
+#include <cstdint>
+#include <functional>
+
+#include "Runnable2.h"
+#include "TelemetryRecord.h"
+
+namespace kc1fsz {
+
+class Log;
+class Clock;
+class VoterClient;
+class TickAligner;
+class DeferredLog;
+
+/**
+ * Sends a telemetry record (see TelemetryRecord.h) to a collector every
+ * few seconds so that a voter in the field can be watched without a
+ * serial cable.
+ *
+ * The exporter keeps out of the way of the audio:
+ * - It has its own socket, so nothing goes through the VOTER lines'
+ *   OutboundScheduler.
+ * - The record is built and sent from run2(), never from a tick, and
+ *   is held back while any line has audio waiting to go out. A line 
+ *   that always has audio waiting would hold it back for good, so after
+ *   one interval of waiting it is sent anyway.
+ * - A send that fails is not retried. The counters are totals, so the
+ *   next record covers the gap.
+ *
+ * It also measures the event loop it runs in: run2() is called once per
+ * pass and the audio tick is timed against the Clock. The pass rate is
+ * logged every ten seconds whether or not there is a collector.
+ */
+class TelemetryExporter : public Runnable2 {
+public:
+
+    static const unsigned DEFAULT_INTERVAL_SEC = 60;
+
+    TelemetryExporter(Log& log, Clock& clock);
+
+    /**
+     * @returns 0 if the open was successful.
+     */
+    int open(const char* collectorAddrAndPort);
+
+    void close();
+
+    void setIntervalSec(unsigned sec) { _intervalSec = sec ? sec : 1; }
+
+    /**
+     * What the collector knows this voter by (i.e. the board's unique 
+     * ID). Cut to telemetry::NODE_ID_SIZE.
+     */
+    void setNodeId(const char* id);
+
+    /**
+     * @returns 0 on success, -1 if there are already MAX_LINES.
+     */
+    int addLine(const VoterClient* line);
+
+    void setAligner(const TickAligner* a) { _aligner = a; }
+
+    void setDeferredLog(const DeferredLog* d) { _dlog = d; }
+
+    /**
+     * Fills in the network counters (i.e. microip_get_stats() on the
+     * Pico).
+     */
+    void setNetStatsSource(std::function<void(telemetry::NetCounters&)> f) {
+        _netSource = f;
+    }
+
+    uint32_t getSentCount() const { return _sentCount; }
+    uint32_t getSendErrorCount() const { return _sendErrorCount; }
+
+    /**
+     * @returns The number of event loop passes since boot.
+     */
+    uint32_t getLoopPasses() const { return _loopPasses; }
+
+    /**
+     * @returns The number of records sent while audio was waiting 
+     * because they had already been held back for a whole interval.
+     */
+    uint32_t getForcedSendCount() const { return _forcedSendCount; }
+
+    /**
+     * Fills in a snapshot of everything as it stands now.
+     */
+    void snapshot(telemetry::Snapshot& s) const;
+
+    // ----- Runnable -------------------------------------------------------
+
+    virtual bool run2();
+    virtual void audioRateTick(uint32_t tickTimeMs);
+    virtual void oneSecTick();
+    virtual void tenSecTick();
+
+private:
+
+    bool _audioPending() const;
+    void _send();
+
+    Log& _log;
+    Clock& _clock;
+    int _sockFd = 0;
+    sockaddr_storage _collectorAddr;
+    unsigned _intervalSec = DEFAULT_INTERVAL_SEC;
+    char _nodeId[telemetry::NODE_ID_SIZE + 1] = { 0 };
+
+    const VoterClient* _lines[telemetry::MAX_LINES];
+    unsigned _lineCount = 0;
+    const TickAligner* _aligner = nullptr;
+    const DeferredLog* _dlog = nullptr;
+    std::function<void(telemetry::NetCounters&)> _netSource;
+
+    bool _sendDue = false;
+    // Seconds the due record has been held back for audio
+    unsigned _deferredSec = 0;
+    unsigned _secCount = 0;
+    uint32_t _uptimeSec = 0;
+    uint32_t _sequence = 0;
+    uint32_t _sentCount = 0;
+    uint32_t _sendErrorCount = 0;
+    uint32_t _forcedSendCount = 0;
+
+    // Event loop measurements
+    uint32_t _loopPasses = 0;
+    uint32_t _reportedLoopPasses = 0;
+    uint32_t _audioTicks = 0;
+    bool _lastTickValid = false;
+    uint32_t _lastTickMs = 0;
+    uint32_t _tickHist[telemetry::TICK_HIST_BUCKETS] = { 0 };
+    // Since the last record
+    uint32_t _maxTickGapMs = 0;
+};
+
+}
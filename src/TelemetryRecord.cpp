@@ -0,0 +1,177 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstring>
+
+#include "TelemetryRecord.h"
+
+namespace kc1fsz {
+namespace telemetry {
+
+namespace {
+
+class Writer {
+public:
+    Writer(uint8_t* p) : _p(p) { }
+    void u8(uint8_t v) { *_p++ = v; }
+    void u16(uint16_t v) { u8(v >> 8); u8(v); }
+    void u32(uint32_t v) { u16(v >> 16); u16(v); }
+    // Null-padded to n
+    void str(const char* s, unsigned n) { 
+        const size_t len = strnlen(s, n);
+        memcpy(_p, s, len);
+        memset(_p + len, 0, n - len);
+        _p += n; 
+    }
+private:
+    uint8_t* _p;
+};
+
+class Reader {
+public:
+    Reader(const uint8_t* p) : _p(p) { }
+    uint8_t u8() { return *_p++; }
+    uint16_t u16() { uint16_t v = (uint16_t)u8() << 8; return v | u8(); }
+    uint32_t u32() { uint32_t v = (uint32_t)u16() << 16; return v | u16(); }
+    // s must have room for n + 1
+    void str(char* s, unsigned n) { memcpy(s, _p, n); s[n] = 0; _p += n; }
+private:
+    const uint8_t* _p;
+};
+
+}
+
+unsigned tickBucket(uint32_t lateMs) {
+    if (lateMs == 0) return 0;
+    if (lateMs == 1) return 1;
+    if (lateMs < 4) return 2;
+    if (lateMs < 8) return 3;
+    return 4;
+}
+
+unsigned encode(const Snapshot& s, uint8_t* buf, unsigned bufCapacity) {
+
+    if (bufCapacity < RECORD_SIZE)
+        return 0;
+    memset(buf, 0, RECORD_SIZE);
+    Writer w(buf);
+
+    w.u32(MAGIC);
+    w.u8(VERSION);
+    w.u8(s.lineCount);
+    w.u16(RECORD_SIZE);
+    w.str(s.nodeId, NODE_ID_SIZE);
+    w.u32(s.sequence);
+    w.u32(s.uptimeSec);
+    w.u16(s.intervalSec);
+    w.u16(s.flags);
+    w.u16((uint16_t)s.phaseErrorMs);
+    w.u16(s.maxTickGapMs);
+
+    w.u32(s.loopPasses);
+    w.u32(s.audioTicks);
+    for (unsigned i = 0; i < TICK_HIST_BUCKETS; i++)
+        w.u32(s.tickHist[i]);
+    w.u32(s.logOverflows);
+
+    w.u32(s.net.rxPackets);
+    w.u32(s.net.rxOverflows);
+    w.u32(s.net.txPackets);
+    w.u32(s.net.txErrors);
+
+    for (unsigned i = 0; i < MAX_LINES; i++) {
+        // Unused lines stay zero
+        const LineStats& l = i < s.lineCount ? s.lines[i] : LineStats();
+        w.u16(l.lineId);
+        w.u16(l.flags);
+        w.u8(l.rssi);
+        w.u8(0);
+        w.u16(l.rttMinMs);
+        w.u16(l.rttMeanMs);
+        w.u16(l.rttP95Ms);
+        w.u16(l.rttMaxMs);
+        w.u32(l.rttCount);
+        w.u32(l.authRejects);
+        w.u32(l.audioSent);
+        w.u32(l.audioDropped);
+        w.u32(l.audioBusy);
+        w.u16(l.audioMaxQueuedMs);
+        w.u32(l.controlSent);
+        w.u32(l.controlDropped);
+        for (unsigned b = 0; b < RTT_HIST_BUCKETS; b++)
+            w.u16(l.rttHist[b]);
+    }
+
+    return RECORD_SIZE;
+}
+
+int decode(const uint8_t* buf, unsigned bufLen, Snapshot& s) {
+
+    if (bufLen != RECORD_SIZE)
+        return -1;
+    Reader r(buf);
+
+    if (r.u32() != MAGIC || r.u8() != VERSION)
+        return -1;
+    s.lineCount = r.u8();
+    if (s.lineCount > MAX_LINES || r.u16() != RECORD_SIZE)
+        return -1;
+    r.str(s.nodeId, NODE_ID_SIZE);
+    s.sequence = r.u32();
+    s.uptimeSec = r.u32();
+    s.intervalSec = r.u16();
+    s.flags = r.u16();
+    s.phaseErrorMs = (int16_t)r.u16();
+    s.maxTickGapMs = r.u16();
+
+    s.loopPasses = r.u32();
+    s.audioTicks = r.u32();
+    for (unsigned i = 0; i < TICK_HIST_BUCKETS; i++)
+        s.tickHist[i] = r.u32();
+    s.logOverflows = r.u32();
+
+    s.net.rxPackets = r.u32();
+    s.net.rxOverflows = r.u32();
+    s.net.txPackets = r.u32();
+    s.net.txErrors = r.u32();
+
+    for (unsigned i = 0; i < MAX_LINES; i++) {
+        LineStats& l = s.lines[i];
+        l.lineId = r.u16();
+        l.flags = r.u16();
+        l.rssi = r.u8();
+        r.u8();
+        l.rttMinMs = r.u16();
+        l.rttMeanMs = r.u16();
+        l.rttP95Ms = r.u16();
+        l.rttMaxMs = r.u16();
+        l.rttCount = r.u32();
+        l.authRejects = r.u32();
+        l.audioSent = r.u32();
+        l.audioDropped = r.u32();
+        l.audioBusy = r.u32();
+        l.audioMaxQueuedMs = r.u16();
+        l.controlSent = r.u32();
+        l.controlDropped = r.u32();
+        for (unsigned b = 0; b < RTT_HIST_BUCKETS; b++)
+            l.rttHist[b] = r.u16();
+    }
+
+    return 0;
+}
+
+}
+}
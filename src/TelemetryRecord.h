@@ -0,0 +1,140 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace kc1fsz {
+
+/**
+ * The telemetry record that a voter sends to its collector (see
+ * TelemetryExporter). One record is one UDP datagram of exactly
+ * RECORD_SIZE bytes, all fields big-endian, in this order:
+ *
+ *   Header (40)
+ *     magic "AMPT" (4), version (1), line count (1), record size (2),
+ *     node id (16, ASCII, null-padded), sequence (4), uptime sec (4),
+ *     interval sec (2), flags (2), tick phase error ms (2, signed), 
+ *     max tick gap ms (2)
+ *   Event loop (32)
+ *     loop passes (4), audio ticks (4), tick lateness histogram (5 x 4),
+ *     deferred log overflows (4)
+ *   Network (16)
+ *     rx packets (4), rx overflows (4), tx packets (4), tx errors (4)
+ *   Line, MAX_LINES times (60 each, unused ones are zero)
+ *     line id (2), flags (2), RSSI (1), pad (1), RTT min/mean/p95/max ms
+ *     (4 x 2), RTT samples (4), auth rejects (4), audio sent/dropped/busy
+ *     (3 x 4), audio max queued ms (2), control sent/dropped (2 x 4),
+ *     RTT histogram (8 x 2)
+ *
+ * The node id says which voter sent the record (the board's unique ID
+ * or a configured name), since the address can change or be shared 
+ * behind NAT. The counters are totals since boot. The collector takes 
+ * differences, so a lost datagram costs resolution but not data.
+ */
+namespace telemetry {
+
+const uint32_t MAGIC = 0x414d5054;
+const uint8_t VERSION = 3;
+// Room for every line on a VoterMux (VoterMux::MAX_LINES, checked in 
+// TelemetryExporter.cpp)
+const unsigned MAX_LINES = 4;
+
+// Tick lateness: on time, 1ms, 2-3ms, 4-7ms, 8ms or more
+const unsigned TICK_HIST_BUCKETS = 5;
+// RTT: 40ms per bucket, the last one takes everything beyond
+const unsigned RTT_HIST_BUCKETS = 8;
+const unsigned RTT_HIST_WIDTH_MS = 40;
+
+const unsigned NODE_ID_SIZE = 16;
+
+const unsigned HEADER_SIZE = 40;
+const unsigned LOOP_SIZE = 32;
+const unsigned NET_SIZE = 16;
+const unsigned LINE_SIZE = 60;
+const unsigned RECORD_SIZE = HEADER_SIZE + LOOP_SIZE + NET_SIZE +
+    MAX_LINES * LINE_SIZE;
+
+// Header flags
+const uint16_t FLAG_ALIGNED = 0x0001;
+const uint16_t FLAG_LOCKED = 0x0002;
+
+// Line flags
+const uint16_t LINE_FLAG_ADPCM = 0x0001;
+
+struct NetCounters {
+    uint32_t rxPackets = 0;
+    uint32_t rxOverflows = 0;
+    uint32_t txPackets = 0;
+    uint32_t txErrors = 0;
+};
+
+struct LineStats {
+    uint16_t lineId = 0;
+    uint16_t flags = 0;
+    uint8_t rssi = 0;
+    uint16_t rttMinMs = 0;
+    uint16_t rttMeanMs = 0;
+    uint16_t rttP95Ms = 0;
+    uint16_t rttMaxMs = 0;
+    uint32_t rttCount = 0;
+    uint32_t authRejects = 0;
+    uint32_t audioSent = 0;
+    uint32_t audioDropped = 0;
+    uint32_t audioBusy = 0;
+    uint16_t audioMaxQueuedMs = 0;
+    uint32_t controlSent = 0;
+    uint32_t controlDropped = 0;
+    uint16_t rttHist[RTT_HIST_BUCKETS] = { 0 };
+};
+
+struct Snapshot {
+    // Null-terminated
+    char nodeId[NODE_ID_SIZE + 1] = { 0 };
+    uint8_t lineCount = 0;
+    uint32_t sequence = 0;
+    uint32_t uptimeSec = 0;
+    uint16_t intervalSec = 0;
+    uint16_t flags = 0;
+    int16_t phaseErrorMs = 0;
+    uint16_t maxTickGapMs = 0;
+    uint32_t loopPasses = 0;
+    uint32_t audioTicks = 0;
+    uint32_t tickHist[TICK_HIST_BUCKETS] = { 0 };
+    uint32_t logOverflows = 0;
+    NetCounters net;
+    LineStats lines[MAX_LINES];
+};
+
+/**
+ * @returns RECORD_SIZE, or 0 if the buffer is too small.
+ */
+unsigned encode(const Snapshot& s, uint8_t* buf, unsigned bufCapacity);
+
+/**
+ * @returns 0 on success, -1 if the datagram isn't a record of this
+ * version.
+ */
+int decode(const uint8_t* buf, unsigned bufLen, Snapshot& s);
+
+/**
+ * @returns The tick lateness bucket for a delay in ms.
+ */
+unsigned tickBucket(uint32_t lateMs);
+
+}
+}
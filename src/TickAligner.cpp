@@ -0,0 +1,180 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/Clock.h"
+
+#include "TickAligner.h"
+
+namespace kc1fsz {
+
+// Ticks in a row within LOCK_LIMIT_MS to count as locked
+static const unsigned LOCK_TICKS = 10;
+
+TickAligner::TickAligner(Log& log, Clock& clock, Runnable2** children, 
+    unsigned childCount)
+:   _log(log),
+    _clock(clock),
+    _children(children),
+    _childCount(childCount) {
+}
+
+void TickAligner::setServerOffset(uint32_t offsetMs) {
+    _offsetMs = offsetMs % TICK_MS;
+    _offsetFixed = true;
+    _offsetValid = true;
+}
+
+void TickAligner::observeServerTime(uint32_t serverMs, uint32_t rxMs, 
+    uint32_t rttMs) {
+
+    if (_offsetFixed)
+        return;
+
+    // Server time minus the one-way delay: the largest value is the
+    // one that was least delayed
+    Sample sample;
+    sample.serverMs = serverMs;
+    sample.rxMs = rxMs;
+    if (_windowCount == 0 || _lessDelayed(sample, _windowMax))
+        _windowMax = sample;
+    if (rttMs && (_windowRttMs == 0 || rttMs < _windowRttMs))
+        _windowRttMs = rttMs;
+    // The least round trip of the two windows. One that was too low 
+    // (or a path that got slower) only lasts as long as its window.
+    if (_windowRttMs && (_lastWindowRttMs == 0 || _windowRttMs < _lastWindowRttMs))
+        _rttMs = _windowRttMs;
+    else if (_lastWindowRttMs)
+        _rttMs = _lastWindowRttMs;
+
+    // A window isn't needed to get started
+    const Sample& best = _lastWindowValid && 
+        _lessDelayed(_lastWindowMax, _windowMax) ? _lastWindowMax : _windowMax;
+    // Worked out at full width, since neither time wraps at a multiple 
+    // of TICK_MS
+    const int64_t offset = (int64_t)best.serverMs + _rttMs / 2 - (int64_t)best.rxMs;
+    _offsetMs = (uint32_t)(((offset % TICK_MS) + TICK_MS) % TICK_MS);
+    // Without the round trip the estimate is off by the whole one-way
+    // delay, so don't steer on it
+    _offsetValid = _rttMs != 0;
+
+    // Two windows are kept so that the estimate can follow a clock that
+    // drifts, without forgetting everything at once
+    if (++_windowCount == WINDOW_SAMPLES) {
+        _lastWindowMax = _windowMax;
+        _lastWindowValid = true;
+        _lastWindowRttMs = _windowRttMs;
+        _windowRttMs = 0;
+        _windowCount = 0;
+    }
+}
+
+bool TickAligner::_lessDelayed(const Sample& a, const Sample& b) {
+    // Compared by difference so that either clock wrapping is harmless
+    return (int32_t)((a.serverMs - a.rxMs) - (b.serverMs - b.rxMs)) > 0;
+}
+
+int32_t TickAligner::_phaseError(uint32_t localMs) const {
+    int32_t e = (int32_t)(((uint64_t)localMs + _offsetMs) % TICK_MS);
+    if (e > (int32_t)(TICK_MS / 2))
+        e -= TICK_MS;
+    return e;
+}
+
+bool TickAligner::isLocked() const {
+    return _offsetValid && _lockedTicks >= LOCK_TICKS;
+}
+
+bool TickAligner::run2() {
+
+    const uint32_t now = _clock.time();
+
+    if (!_started) {
+        _nextTickMs = now + TICK_MS;
+        _started = true;
+    }
+    else if ((int32_t)(now - _nextTickMs) >= 0) {
+
+        if ((int32_t)(now - _nextTickMs) > (int32_t)RESYNC_MS) {
+            _stats.resyncs++;
+            _nextTickMs = now;
+        }
+        else if (now - _nextTickMs > 1)
+            _stats.lateTicks++;
+
+        const uint32_t tickMs = _nextTickMs;
+        for (unsigned i = 0; i < _childCount; i++)
+            _children[i]->audioRateTick(tickMs);
+        _stats.ticks++;
+
+        int32_t step = 0;
+        if (_offsetValid) {
+            _phaseErrorMs = _phaseError(tickMs);
+            int32_t a = _phaseErrorMs < 0 ? -_phaseErrorMs : _phaseErrorMs;
+            if (a > _stats.maxAbsErrorMs)
+                _stats.maxAbsErrorMs = a;
+            if (a <= LOCK_LIMIT_MS) {
+                if (_lockedTicks < LOCK_TICKS)
+                    _lockedTicks++;
+            } else
+                _lockedTicks = 0;
+            // Late ticks come sooner, early ticks later
+            step = -_phaseErrorMs;
+            if (step > MAX_STEP_MS) step = MAX_STEP_MS;
+            if (step < -MAX_STEP_MS) step = -MAX_STEP_MS;
+            if (step)
+                _stats.nudges++;
+        }
+        _nextTickMs = tickMs + TICK_MS + step;
+    }
+
+    bool busy = false;
+    for (unsigned i = 0; i < _childCount; i++)
+        if (_children[i]->run2())
+            busy = true;
+    return busy;
+}
+
+void TickAligner::audioRateTick(uint32_t) {
+    // The children get their ticks from run2()
+}
+
+void TickAligner::oneSecTick() {
+    for (unsigned i = 0; i < _childCount; i++)
+        _children[i]->oneSecTick();
+}
+
+void TickAligner::tenSecTick() {
+    if (_trace)
+        _log.info("Tick phase error %d ms (max %d), offset %u, nudges %u, late %u, %s",
+            _phaseErrorMs, _stats.maxAbsErrorMs, _offsetMs, _stats.nudges, 
+            _stats.lateTicks, isLocked() ? "locked" : "unlocked");
+    _stats.maxAbsErrorMs = 0;
+    for (unsigned i = 0; i < _childCount; i++)
+        _children[i]->tenSecTick();
+}
+
+int TickAligner::getPolls(pollfd* fds, unsigned fdsCapacity) {
+    int used = 0;
+    for (unsigned i = 0; i < _childCount; i++) {
+        int rc = _children[i]->getPolls(fds + used, fdsCapacity - used);
+        if (rc > 0)
+            used += rc;
+    }
+    return used;
+}
+
+}
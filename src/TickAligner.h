@@ -0,0 +1,160 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "Runnable2.h"
+
+namespace kc1fsz {
+
+class Log;
+class Clock;
+
+/**
+ * Puts the audio tick of a group of tasks on the server's 20ms frame
+ * boundaries, so that the server doesn't need to buffer extra to line
+ * up frames from receivers with arbitrary offsets.
+ *
+ * The aligner is a composite task: the children are given to the 
+ * aligner instead of the event loop. Their run2()/oneSecTick()/
+ * tenSecTick()/getPolls() are passed through, but the audio tick comes
+ * from the aligner's own schedule (checked in run2()) and the event 
+ * loop's tick is ignored.
+ *
+ * The offset between the local Clock and the server timebase is either
+ * given directly (i.e. when the local clock is disciplined to UTC) or
+ * estimated from the time stamps on server packets: the maximum of
+ * (server time - local receive time) over a window (the least delayed
+ * packet), plus half of the minimum round trip over the same windows
+ * (so that one bad measurement doesn't stay forever). Only the offset's 
+ * position within the 20ms frame is kept, so server times only have to
+ * be right modulo a multiple of TICK_MS (see voter::TIME_WRAP_MS). Each
+ * tick the schedule is nudged by up to MAX_STEP_MS towards the nearest
+ * boundary.
+ */
+class TickAligner : public Runnable2 {
+public:
+
+    static const uint32_t TICK_MS = 20;
+    static const int32_t MAX_STEP_MS = 1;
+    // Server time samples per estimation window
+    static const unsigned WINDOW_SAMPLES = 64;
+    // The schedule is restarted if it falls this far behind
+    static const uint32_t RESYNC_MS = 200;
+    // Phase error (ms) that counts as locked
+    static const int32_t LOCK_LIMIT_MS = 1;
+
+    struct Stats {
+        uint32_t ticks = 0;
+        uint32_t nudges = 0;
+        uint32_t resyncs = 0;
+        // Ticks fired more than 1ms after their scheduled time
+        uint32_t lateTicks = 0;
+        // Largest |phase error| since the last tenSecTick()
+        int32_t maxAbsErrorMs = 0;
+    };
+
+    TickAligner(Log& log, Clock& clock, Runnable2** children, unsigned childCount);
+
+    /**
+     * Fixes the offset: server (wall) time = local time + offsetMs. This
+     * turns off the estimation. Only offsetMs modulo TICK_MS matters, so
+     * a UTC offset can be given as (utcMsAtZero % TICK_MS).
+     */
+    void setServerOffset(uint32_t offsetMs);
+
+    /**
+     * Feeds the estimator (see VoterClient::setServerTimeObserver).
+     *
+     * @param serverMs The server's time stamp on the packet, modulo a 
+     * multiple of TICK_MS
+     * @param rxMs Local time of arrival
+     * @param rttMs The most recent round trip, or 0 if unknown
+     */
+    void observeServerTime(uint32_t serverMs, uint32_t rxMs, uint32_t rttMs);
+
+    /**
+     * @returns true once there is an offset to align to.
+     */
+    bool hasOffset() const { return _offsetValid; }
+
+    /**
+     * @returns The offset in use, from 0 to TICK_MS - 1: server time = 
+     * local time + offset, modulo TICK_MS.
+     */
+    uint32_t getServerOffset() const { return _offsetMs; }
+
+    /**
+     * @returns The phase error at the most recent tick in ms, from -9 to
+     * +10. Positive means the tick happened after the boundary.
+     */
+    int32_t getPhaseErrorMs() const { return _phaseErrorMs; }
+
+    bool isLocked() const;
+
+    void setTrace(bool a) { _trace = a; }
+
+    const Stats& getStats() const { return _stats; }
+
+    // ----- Runnable -------------------------------------------------------
+
+    virtual bool run2();
+    virtual void audioRateTick(uint32_t tickTimeMs);
+    virtual void oneSecTick();
+    virtual void tenSecTick();
+    virtual int getPolls(pollfd* fds, unsigned fdsCapacity);
+
+private:
+
+    // A server time stamp and when it arrived
+    struct Sample {
+        uint32_t serverMs = 0;
+        uint32_t rxMs = 0;
+    };
+
+    static bool _lessDelayed(const Sample& a, const Sample& b);
+    int32_t _phaseError(uint32_t localMs) const;
+
+    Log& _log;
+    Clock& _clock;
+    Runnable2** _children;
+    const unsigned _childCount;
+    bool _trace = false;
+
+    bool _started = false;
+    uint32_t _nextTickMs = 0;
+
+    bool _offsetFixed = false;
+    bool _offsetValid = false;
+    uint32_t _offsetMs = 0;
+    // Windowed maximum of (server - local receive)
+    unsigned _windowCount = 0;
+    Sample _windowMax;
+    Sample _lastWindowMax;
+    bool _lastWindowValid = false;
+    // Minimum round trip per window, 0 if there was none
+    uint32_t _windowRttMs = 0;
+    uint32_t _lastWindowRttMs = 0;
+    uint32_t _rttMs = 0;
+
+    int32_t _phaseErrorMs = 0;
+    unsigned _lockedTicks = 0;
+    Stats _stats;
+};
+
+}
@@ -0,0 +1,284 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cmath>
+
+#include "ToneDetector.h"
+
+namespace kc1fsz {
+
+const uint16_t ToneDetector::STANDARD_CTCSS[STANDARD_CTCSS_COUNT] = {
+    670, 693, 719, 744, 770, 797, 825, 854, 885, 915,
+    948, 974, 1000, 1035, 1072, 1109, 1148, 1188, 1230, 1273,
+    1318, 1365, 1413, 1462, 1500, 1514, 1567, 1598, 1622, 1655,
+    1679, 1713, 1738, 1773, 1799, 1835, 1862, 1899, 1928, 1966,
+    1995, 2035, 2065, 2107, 2181, 2257, 2291, 2336, 2418, 2503,
+    2541
+};
+
+static const float DTMF_FREQS[8] = { 697, 770, 852, 941, 1209, 1336, 1477, 1633 };
+
+static const char DTMF_DIGITS[4][4] = {
+    { '1', '2', '3', 'A' },
+    { '4', '5', '6', 'B' },
+    { '7', '8', '9', 'C' },
+    { '*', '0', '#', 'D' }
+};
+
+// Samples are scaled down by this much going in, which keeps the
+// Goertzel state inside of 32 bits for the longest (CTCSS) block.
+static const unsigned INPUT_SHIFT = 4;
+// Minimum block energy (per sample, after scaling) to consider at all
+static const int64_t ENERGY_FLOOR = 64;
+// Share of the block energy that a bin needs, as 1/N
+static const int64_t CTCSS_SHARE = 8;
+static const int64_t DTMF_SHARE = 4;
+// The short block lets more of a nearby tone in, so it asks for more
+static const int64_t CTCSS_GATE_SHARE = 3;
+// The CTCSS energy reference is taken after two one-pole low-pass
+// stages at ~300 Hz (Q15) so that voice doesn't swamp the tone
+static const int32_t CTCSS_LP_A = 6900;
+// Blocks needed to declare a DTMF digit, and to release anything
+static const unsigned DTMF_HITS = 2;
+static const unsigned RELEASE_MISSES = 2;
+
+void ToneDetector::Bin::setFreq(float hz) {
+    coef = (int32_t)std::lround(2.0 * std::cos(2.0 * 3.14159265358979 * hz / 8000.0) *
+        (double)(1 << 29));
+    s1 = 0;
+    s2 = 0;
+}
+
+int64_t ToneDetector::Bin::power() {
+    int64_t p = (int64_t)s1 * s1 + (int64_t)s2 * s2 -
+        (((int64_t)coef * s1) >> 29) * s2;
+    s1 = 0;
+    s2 = 0;
+    return p;
+}
+
+ToneDetector::ToneDetector() {
+    for (unsigned i = 0; i < 8; i++)
+        _dtmfBins[i].setFreq(DTMF_FREQS[i]);
+}
+
+int ToneDetector::addCtcssTone(uint16_t freqTenths) {
+    if (_ctcssCount == MAX_CTCSS)
+        return -1;
+    _ctcssFreq[_ctcssCount] = freqTenths;
+    _ctcssBins[_ctcssCount].setFreq((float)freqTenths / 10.0f);
+    _gateBins[_ctcssCount].setFreq((float)freqTenths / 10.0f);
+    _ctcssCount++;
+    reset();
+    return 0;
+}
+
+void ToneDetector::clearCtcssTones() {
+    _ctcssCount = 0;
+    reset();
+}
+
+void ToneDetector::reset() {
+    for (unsigned i = 0; i < _ctcssCount; i++) {
+        _ctcssBins[i].power();
+        _gateBins[i].power();
+    }
+    for (unsigned i = 0; i < 8; i++)
+        _dtmfBins[i].power();
+    _ctcssN = 0;
+    _ctcssEnergy = 0;
+    _ctcssLp1 = 0;
+    _ctcssLp2 = 0;
+    _ctcssActive = 0;
+    _ctcssMisses = 0;
+    _gateN = 0;
+    _gateEnergy = 0;
+    _gateOpen = false;
+    _gateMisses = 0;
+    _gateOpenN = 0;
+    _gateVeto = false;
+    _dtmfN = 0;
+    _dtmfEnergy = 0;
+    _dtmfCandidate = 0;
+    _dtmfHits = 0;
+    _dtmfActive = 0;
+    _dtmfMisses = 0;
+}
+
+unsigned ToneDetector::process(const int16_t* pcm, unsigned len, Event* events,
+    unsigned eventsCapacity) {
+
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < len; i++) {
+
+        const int32_t x = pcm[i] >> INPUT_SHIFT;
+
+        if (_ctcssCount) {
+            for (unsigned k = 0; k < _ctcssCount; k++) {
+                _ctcssBins[k].update(x);
+                _gateBins[k].update(x);
+            }
+            _ctcssLp1 += ((x - _ctcssLp1) * CTCSS_LP_A) >> 15;
+            _ctcssLp2 += ((_ctcssLp1 - _ctcssLp2) * CTCSS_LP_A) >> 15;
+            const int32_t e = _ctcssLp2 * _ctcssLp2;
+            _ctcssEnergy += e;
+            _gateEnergy += e;
+            if (_gateOpen && _gateOpenN < CTCSS_BLOCK)
+                _gateOpenN++;
+            if (++_gateN == CTCSS_GATE_BLOCK)
+                _gateBlockDone();
+            if (++_ctcssN == CTCSS_BLOCK)
+                _ctcssBlockDone(events, eventsCapacity, count);
+        }
+
+        if (_dtmfOn) {
+            for (unsigned k = 0; k < 8; k++)
+                _dtmfBins[k].update(x);
+            _dtmfEnergy += x * x;
+            if (++_dtmfN == DTMF_BLOCK)
+                _dtmfBlockDone(events, eventsCapacity, count);
+        }
+    }
+
+    return count;
+}
+
+void ToneDetector::_ctcssBlockDone(Event* events, unsigned cap, unsigned& count) {
+
+    // A bin's share of the energy is 2P/(N*E), which is about 1 for a 
+    // pure tone
+    const int64_t ne = (int64_t)CTCSS_BLOCK * _ctcssEnergy;
+    int best = -1;
+    int64_t bestP = 0;
+    for (unsigned k = 0; k < _ctcssCount; k++) {
+        int64_t p = _ctcssBins[k].power();
+        if (p > bestP) {
+            bestP = p;
+            best = k;
+        }
+    }
+    bool hit = best >= 0 &&
+        _ctcssEnergy >= ENERGY_FLOOR * (int64_t)CTCSS_BLOCK &&
+        2 * bestP * CTCSS_SHARE >= ne;
+    _ctcssN = 0;
+    _ctcssEnergy = 0;
+
+    // A miss over a block that the gate was open for all of means the 
+    // short block was fooled (i.e. by a nearby tone)
+    if (hit)
+        _gateVeto = false;
+    else if (_gateOpen && _gateOpenN >= CTCSS_BLOCK)
+        _gateVeto = true;
+
+    if (hit) {
+        uint16_t f = _ctcssFreq[best];
+        _ctcssMisses = 0;
+        if (f != _ctcssActive) {
+            if (_ctcssActive && count < cap)
+                events[count++] = { Event::CTCSS_OFF, _ctcssActive, 0 };
+            _ctcssActive = f;
+            if (count < cap)
+                events[count++] = { Event::CTCSS_ON, f, 0 };
+        }
+    }
+    else if (_ctcssActive && ++_ctcssMisses >= RELEASE_MISSES) {
+        if (count < cap)
+            events[count++] = { Event::CTCSS_OFF, _ctcssActive, 0 };
+        _ctcssActive = 0;
+        _ctcssMisses = 0;
+    }
+}
+
+void ToneDetector::_gateBlockDone() {
+
+    // The same test as the long block, with a higher share
+    const int64_t ne = (int64_t)CTCSS_GATE_BLOCK * _gateEnergy;
+    int64_t bestP = 0;
+    for (unsigned k = 0; k < _ctcssCount; k++) {
+        int64_t p = _gateBins[k].power();
+        if (p > bestP)
+            bestP = p;
+    }
+    bool hit = bestP > 0 &&
+        _gateEnergy >= ENERGY_FLOOR * (int64_t)CTCSS_GATE_BLOCK &&
+        2 * bestP * CTCSS_GATE_SHARE >= ne;
+    _gateN = 0;
+    _gateEnergy = 0;
+
+    if (hit) {
+        _gateMisses = 0;
+        if (!_gateOpen) {
+            _gateOpen = true;
+            _gateOpenN = 0;
+        }
+    }
+    else if (_gateOpen && ++_gateMisses >= RELEASE_MISSES) {
+        _gateOpen = false;
+        _gateMisses = 0;
+        _gateVeto = false;
+    }
+}
+
+void ToneDetector::_dtmfBlockDone(Event* events, unsigned cap, unsigned& count) {
+
+    int64_t p[8];
+    for (unsigned k = 0; k < 8; k++)
+        p[k] = _dtmfBins[k].power();
+
+    // Strongest row (0-3) and column (4-7)
+    unsigned r = 0, c = 4;
+    for (unsigned k = 1; k < 4; k++)
+        if (p[k] > p[r]) r = k;
+    for (unsigned k = 5; k < 8; k++)
+        if (p[k] > p[c]) c = k;
+
+    const int64_t ne = (int64_t)DTMF_BLOCK * _dtmfEnergy;
+    bool hit = _dtmfEnergy >= ENERGY_FLOOR * (int64_t)DTMF_BLOCK &&
+        2 * p[r] * DTMF_SHARE >= ne &&
+        2 * p[c] * DTMF_SHARE >= ne &&
+        // Twist limit (about 9 dB either way)
+        p[r] <= 8 * p[c] && p[c] <= 8 * p[r];
+    _dtmfN = 0;
+    _dtmfEnergy = 0;
+
+    char digit = hit ? DTMF_DIGITS[r][c - 4] : 0;
+
+    if (digit) {
+        _dtmfMisses = 0;
+        if (digit == _dtmfCandidate)
+            _dtmfHits++;
+        else {
+            _dtmfCandidate = digit;
+            _dtmfHits = 1;
+        }
+        if (_dtmfHits >= DTMF_HITS && _dtmfActive != digit) {
+            _dtmfActive = digit;
+            if (count < cap)
+                events[count++] = { Event::DTMF, 0, digit };
+        }
+    }
+    else {
+        _dtmfCandidate = 0;
+        _dtmfHits = 0;
+        if (_dtmfActive && ++_dtmfMisses >= RELEASE_MISSES) {
+            _dtmfActive = 0;
+            _dtmfMisses = 0;
+        }
+    }
+}
+
+}
@@ -0,0 +1,174 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace kc1fsz {
+
+/**
+ * Streaming CTCSS and DTMF detection using Goertzel bins. Audio is fed
+ * in whatever frame size is convenient (normally 160 samples) and the
+ * bins are evaluated whenever a block completes:
+ *
+ * - CTCSS: only the configured tones are watched (up to MAX_CTCSS). The
+ *   block is 4000 samples (0.5s) which is long enough to separate the
+ *   closest tones in the standard set.
+ * - CTCSS gate: the same tones on a 1600 sample (0.2s) block. This can
+ *   only tell tones apart that are more than ~5 Hz from each other, but 
+ *   it opens the gate (see isCtcssGateOpen()) well before the long block
+ *   has decided. If the long block then finds that the tone isn't a 
+ *   watched one the gate is shut until the tone goes away.
+ * - DTMF: the usual 8 bins with the classic 205 sample block.
+ *
+ * A tone counts as present when its bin holds a minimum share of the
+ * block energy (for CTCSS the energy is measured after a low-pass so
+ * that voice doesn't mask the tone). Hysteresis is applied on top of
+ * that. All of the arithmetic is integer (the Goertzel products are 
+ * 64-bit) and nothing is allocated.
+ */
+class ToneDetector {
+public:
+
+    static const unsigned MAX_CTCSS = 4;
+    static const unsigned CTCSS_BLOCK = 4000;
+    static const unsigned CTCSS_GATE_BLOCK = 1600;
+    static const unsigned DTMF_BLOCK = 205;
+
+    // The standard CTCSS tones in tenths of Hz
+    static const unsigned STANDARD_CTCSS_COUNT = 51;
+    static const uint16_t STANDARD_CTCSS[STANDARD_CTCSS_COUNT];
+
+    struct Event {
+        enum Kind { CTCSS_ON, CTCSS_OFF, DTMF };
+        Kind kind;
+        // CTCSS frequency in tenths of Hz
+        uint16_t freqTenths;
+        // DTMF digit
+        char digit;
+    };
+
+    ToneDetector();
+
+    /**
+     * Starts watching a CTCSS tone.
+     *
+     * @param freqTenths Frequency in tenths of Hz (i.e. 1000 for 100.0 Hz)
+     * @returns 0 on success, -1 if the tone table is full.
+     */
+    int addCtcssTone(uint16_t freqTenths);
+
+    void clearCtcssTones();
+
+    unsigned getCtcssCount() const { return _ctcssCount; }
+
+    void setDtmfEnabled(bool on) { _dtmfOn = on; }
+
+    bool isActive() const { return _ctcssCount > 0 || _dtmfOn; }
+
+    /**
+     * Feeds audio in.
+     *
+     * @returns The number of events written to the events array.
+     */
+    unsigned process(const int16_t* pcm, unsigned len, Event* events,
+        unsigned eventsCapacity);
+
+    /**
+     * @returns The CTCSS tone that is present (in tenths of Hz) or 0.
+     */
+    uint16_t getActiveCtcss() const { return _ctcssActive; }
+
+    /**
+     * @returns true if audio should be let through because one of the
+     * watched CTCSS tones is (or is very likely to be) present. This 
+     * follows the short block only, so it opens 0.2-0.4s after the tone
+     * arrives and closes about as quickly after it leaves, where 
+     * getActiveCtcss() takes 0.5-1s either way. The long block can only
+     * veto it.
+     */
+    bool isCtcssGateOpen() const { return _gateOpen && !_gateVeto; }
+
+    void reset();
+
+private:
+
+    struct Bin {
+        // 2cos(w) in Q29
+        int32_t coef = 0;
+        int32_t s1 = 0;
+        int32_t s2 = 0;
+        void setFreq(float hz);
+        void update(int32_t x) {
+            int32_t s = x + (int32_t)(((int64_t)coef * s1) >> 29) - s2;
+            s2 = s1;
+            s1 = s;
+        }
+        // Un-normalized power of the bin, then clears the state
+        int64_t power();
+    };
+
+    void _ctcssBlockDone(Event* events, unsigned cap, unsigned& count);
+    void _gateBlockDone();
+    void _dtmfBlockDone(Event* events, unsigned cap, unsigned& count);
+
+    // CTCSS
+    uint16_t _ctcssFreq[MAX_CTCSS];
+    Bin _ctcssBins[MAX_CTCSS];
+    unsigned _ctcssCount = 0;
+    unsigned _ctcssN = 0;
+    int64_t _ctcssEnergy = 0;
+    int32_t _ctcssLp1 = 0;
+    int32_t _ctcssLp2 = 0;
+    uint16_t _ctcssActive = 0;
+    unsigned _ctcssMisses = 0;
+
+    // CTCSS gate (short block)
+    Bin _gateBins[MAX_CTCSS];
+    unsigned _gateN = 0;
+    int64_t _gateEnergy = 0;
+    bool _gateOpen = false;
+    unsigned _gateMisses = 0;
+    // Samples since the gate opened (stops counting at CTCSS_BLOCK)
+    unsigned _gateOpenN = 0;
+    // The long block didn't agree with the short one
+    bool _gateVeto = false;
+
+    // DTMF
+    bool _dtmfOn = false;
+    Bin _dtmfBins[8];
+    unsigned _dtmfN = 0;
+    int64_t _dtmfEnergy = 0;
+    char _dtmfCandidate = 0;
+    unsigned _dtmfHits = 0;
+    char _dtmfActive = 0;
+    unsigned _dtmfMisses = 0;
+};
+
+/**
+ * The body of the SIGNAL messages that carry tone detections around the
+ * router. The message format field holds the ToneDetector::Event::Kind.
+ */
+struct ToneSignal {
+    uint8_t kind;
+    char digit;
+    uint16_t freqTenths;
+    // The line that heard the tone
+    uint32_t lineId;
+};
+
+}
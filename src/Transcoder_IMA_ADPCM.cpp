@@ -0,0 +1,124 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Transcoder_IMA_ADPCM.h"
+
+namespace kc1fsz {
+
+static const int16_t STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t INDEX_TABLE[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+// One code through the decoder, shared by both sides so that they stay
+// in step
+static inline void step(int32_t& predictor, int32_t& index, unsigned code) {
+    const int32_t s = STEP_TABLE[index];
+    int32_t diff = s >> 3;
+    if (code & 4) diff += s;
+    if (code & 2) diff += s >> 1;
+    if (code & 1) diff += s >> 2;
+    predictor += (code & 8) ? -diff : diff;
+    if (predictor > 32767) predictor = 32767;
+    else if (predictor < -32768) predictor = -32768;
+    index += INDEX_TABLE[code];
+    if (index < 0) index = 0;
+    else if (index > 88) index = 88;
+}
+
+static inline unsigned quantize(int32_t predictor, int32_t index, int32_t x) {
+    int32_t s = STEP_TABLE[index];
+    int32_t diff = x - predictor;
+    unsigned code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= s) { code |= 4; diff -= s; }
+    s >>= 1;
+    if (diff >= s) { code |= 2; diff -= s; }
+    s >>= 1;
+    if (diff >= s) { code |= 1; }
+    return code;
+}
+
+void Transcoder_IMA_ADPCM::reset() {
+    _predictor = 0;
+    _index = 0;
+}
+
+unsigned Transcoder_IMA_ADPCM::encode(const int16_t* in, unsigned n, 
+    uint8_t* out, unsigned outCapacity) {
+
+    const unsigned len = HEADER_SIZE + n / 2;
+    if ((n & 1) || outCapacity < len)
+        return 0;
+
+    out[0] = (_predictor >> 8) & 0xff;
+    out[1] = _predictor & 0xff;
+    out[2] = _index;
+
+    // Locals so the compiler can keep the state in registers
+    int32_t p = _predictor, ix = _index;
+    uint8_t* o = out + HEADER_SIZE;
+    for (unsigned i = 0; i < n; i += 2) {
+        unsigned lo = quantize(p, ix, in[i]);
+        step(p, ix, lo);
+        unsigned hi = quantize(p, ix, in[i + 1]);
+        step(p, ix, hi);
+        *o++ = lo | (hi << 4);
+    }
+    _predictor = p;
+    _index = ix;
+
+    return len;
+}
+
+unsigned Transcoder_IMA_ADPCM::decode(const uint8_t* in, unsigned inLen, 
+    int16_t* out, unsigned outCapacity) {
+
+    if (inLen < HEADER_SIZE)
+        return 0;
+    const unsigned n = (inLen - HEADER_SIZE) * 2;
+    if (outCapacity < n)
+        return 0;
+
+    int32_t p = (int16_t)((in[0] << 8) | in[1]);
+    int32_t ix = in[2] > 88 ? 88 : in[2];
+    const uint8_t* c = in + HEADER_SIZE;
+    for (unsigned i = 0; i < n; i += 2, c++) {
+        step(p, ix, *c & 0x0f);
+        out[i] = p;
+        step(p, ix, *c >> 4);
+        out[i + 1] = p;
+    }
+
+    return n;
+}
+
+}
@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace kc1fsz {
+
+/**
+ * IMA ADPCM (4 bits per sample) for the VOTER ADPCM payload type. A 20ms
+ * frame of 160 samples becomes 83 bytes:
+ *
+ *   0  predictor at the start of the frame (16-bit, big-endian)
+ *   2  step index at the start of the frame
+ *   3  80 bytes of codes, two per byte, first sample in the low nibble
+ *
+ * This layout is this project's own. It has NOT been checked against 
+ * the reference server's (chan_voter) ADPCM handling, which may use a 
+ * different frame size, variant or nibble order. So VoterClient only 
+ * uses it in the host tools (AMP_VOTER_SIM_ADPCM), against the 
+ * simulated server.
+ *
+ * Every frame carries the state it starts from so a lost packet doesn't
+ * upset the decoder. The encoder carries its state from frame to frame.
+ * Integer only, nothing is allocated.
+ */
+class Transcoder_IMA_ADPCM {
+public:
+
+    static const unsigned FRAME_SAMPLES = 160;
+    static const unsigned HEADER_SIZE = 3;
+    static const unsigned FRAME_SIZE = HEADER_SIZE + FRAME_SAMPLES / 2;
+
+    /**
+     * @param n Number of samples, must be even
+     * @returns The number of bytes written, or 0 if the output doesn't
+     * have room.
+     */
+    unsigned encode(const int16_t* in, unsigned n, uint8_t* out, unsigned outCapacity);
+
+    /**
+     * @returns The number of samples written, or 0 if the input is too
+     * short or the output doesn't have room.
+     */
+    unsigned decode(const uint8_t* in, unsigned inLen, int16_t* out, 
+        unsigned outCapacity);
+
+    void reset();
+
+private:
+
+    int32_t _predictor = 0;
+    int32_t _index = 0;
+};
+
+}
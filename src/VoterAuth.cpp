@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstring>
+
+#include "VoterAuth.h"
+
+namespace kc1fsz {
+
+void VoterAuth::setLocalChallenge(const char* c) {
+    strncpy(_localChallenge, c, sizeof(_localChallenge) - 1);
+    _updateInbound();
+}
+
+void VoterAuth::setLocalPassword(const char* p) {
+    strncpy(_localPassword, p, sizeof(_localPassword) - 1);
+    _updateOutbound();
+}
+
+void VoterAuth::setRemotePassword(const char* p) {
+    strncpy(_remotePassword, p, sizeof(_remotePassword) - 1);
+    _updateInbound();
+}
+
+void VoterAuth::observeRemoteChallenge(const uint8_t* packet) {
+    const char* c = (const char*)packet + voter::OFFSET_CHALLENGE;
+    // The challenge on the wire is null-padded to 10 bytes
+    if (strncmp(c, _remoteChallenge, voter::CHALLENGE_SIZE) == 0)
+        return;
+    memcpy(_remoteChallenge, c, voter::CHALLENGE_SIZE);
+    _remoteChallenge[voter::CHALLENGE_SIZE] = 0;
+    _updateOutbound();
+}
+
+void VoterAuth::_updateInbound() {
+    _inboundDigest = voter::crc32(_localChallenge, _remotePassword);
+    _inboundWire[0] = (_inboundDigest >> 24) & 0xff;
+    _inboundWire[1] = (_inboundDigest >> 16) & 0xff;
+    _inboundWire[2] = (_inboundDigest >> 8) & 0xff;
+    _inboundWire[3] = _inboundDigest & 0xff;
+    _computeCount++;
+}
+
+void VoterAuth::_updateOutbound() {
+    if (_remoteChallenge[0] == 0) {
+        _outboundDigest = 0;
+        return;
+    }
+    _outboundDigest = voter::crc32(_remoteChallenge, _localPassword);
+    _computeCount++;
+}
+
+}
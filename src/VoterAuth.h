@@ -0,0 +1,92 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "VoterProto.h"
+
+namespace kc1fsz {
+
+/**
+ * Caches the two VOTER authenticators for a session so that nothing
+ * is re-derived on the per-packet path:
+ *
+ * - Inbound: the server signs its packets with CRC32(our challenge +
+ *   server password). This only changes when one of those is set, so it
+ *   is computed once and kept in wire (big-endian) order for checking.
+ * - Outbound: we sign with CRC32(server challenge + our password). This
+ *   is recomputed only when the server's challenge actually changes.
+ */
+class VoterAuth {
+public:
+
+    void setLocalChallenge(const char* c);
+    void setLocalPassword(const char* p);
+    void setRemotePassword(const char* p);
+
+    const char* getLocalChallenge() const { return _localChallenge; }
+
+    uint32_t getInboundDigest() const { return _inboundDigest; }
+
+    /**
+     * Checks the digest on an inbound packet. The comparison doesn't
+     * exit early so the timing doesn't say how much of it was right.
+     * The packet must have a complete header.
+     */
+    bool isInboundAuthentic(const uint8_t* packet) const {
+        const uint8_t* d = packet + voter::OFFSET_DIGEST;
+        uint8_t diff = (d[0] ^ _inboundWire[0]) | (d[1] ^ _inboundWire[1]) |
+            (d[2] ^ _inboundWire[2]) | (d[3] ^ _inboundWire[3]);
+        return diff == 0;
+    }
+
+    /**
+     * Called with each authentic inbound packet to pick up the server's
+     * challenge. Cheap when the challenge hasn't changed.
+     */
+    void observeRemoteChallenge(const uint8_t* packet);
+
+    /**
+     * @returns The digest for outbound packets, or 0 if the server's
+     * challenge isn't known yet.
+     */
+    uint32_t getOutboundDigest() const { return _outboundDigest; }
+
+    /**
+     * @returns The number of times a digest was actually computed. Useful
+     * for confirming that the cache is working.
+     */
+    uint32_t getComputeCount() const { return _computeCount; }
+
+private:
+
+    void _updateInbound();
+    void _updateOutbound();
+
+    char _localChallenge[32] = { 0 };
+    char _localPassword[32] = { 0 };
+    char _remotePassword[32] = { 0 };
+    char _remoteChallenge[voter::CHALLENGE_SIZE + 1] = { 0 };
+
+    uint32_t _inboundDigest = 0;
+    uint8_t _inboundWire[4] = { 0 };
+    uint32_t _outboundDigest = 0;
+    uint32_t _computeCount = 0;
+};
+
+}
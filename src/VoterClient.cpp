@@ -42,18 +42,15 @@
 
 #include "VoterPeer.h"
 #include "VoterUtil.h"
+#include "VoterProto.h"
+#include "VoterMux.h"
+#include "DeferredLog.h"
 #include "VoterClient.h"
 
 using namespace std;
 
 namespace kc1fsz {
 
-/*    
-static uint32_t alignToTick(uint32_t ts, uint32_t tick) {
-    return (ts / tick) * tick;
-}
-*/
-
 VoterClient::VoterClient(Log& log, Clock& clock, int lineId,
     MessageConsumer& bus)
 :   _log(log),
@@ -69,6 +66,11 @@ VoterClient::VoterClient(Log& log, Clock& clock, int lineId,
             _sendPacketToPeer(data, dataLen, addr);
         }
     );
+    _scheduler.setSender([this]
+        (const uint8_t* data, unsigned dataLen, const sockaddr& addr) {
+            return _writePacket(data, dataLen, addr);
+        }
+    );
 }
 
 int VoterClient::open(const char* serverAddrAndPort) {
@@ -115,52 +117,259 @@ int VoterClient::open(const char* serverAddrAndPort) {
     return 0;
 }
 
+int VoterClient::open(const char* serverAddrAndPort, VoterMux& mux) {
+
+    close();
+
+    int rc = parseIPAddrAndPort(serverAddrAndPort, _serverAddr);
+    if (rc != 0) {
+        return -1;
+    }
+    _addrFamily = _serverAddr.ss_family;
+
+    if (!mux.getFd()) {
+        _log.error("Shared Voter port is not open");
+        return -1;
+    }
+    if (mux.addLine(this) != 0) {
+        _log.error("No room for line %u on shared Voter port", _lineId);
+        return -1;
+    }
+
+    _sockFd = mux.getFd();
+    _mux = &mux;
+
+    _client.setPeerAddr(_serverAddr);
+
+    _log.info("Line %u opened shared connection to %s", _lineId, serverAddrAndPort);
+
+    return 0;
+}
+
 void VoterClient::close() {   
-    if (_sockFd) 
+    if (_mux)
+        _mux->removeLine(this);
+    else if (_sockFd) 
         ::close(_sockFd);
     _sockFd = 0;
+    _mux = nullptr;
+    _scheduler.clear();
     _listenPort = 0;
     _addrFamily = 0;
 } 
 
 void VoterClient::setServerPassword(const char* p) {
     _client.setRemotePassword(p);
+    _auth.setRemotePassword(p);
 }
 
 void VoterClient::setClientPassword(const char* p) {
     // A random challenge for security 
-    _client.setLocalChallenge(amp::VoterPeer::makeChallenge().c_str());
+    _auth.setLocalChallenge(amp::VoterPeer::makeChallenge().c_str());
+    _client.setLocalChallenge(_auth.getLocalChallenge());
     _client.setLocalPassword(p);
+    _auth.setLocalPassword(p);
+}
+
+bool VoterClient::isFromServer(const sockaddr& addr) const {
+    if (addr.sa_family != _serverAddr.ss_family)
+        return false;
+    if (addr.sa_family == AF_INET) {
+        const sockaddr_in& a = (const sockaddr_in&)addr;
+        const sockaddr_in& b = (const sockaddr_in&)_serverAddr;
+        return a.sin_port == b.sin_port && a.sin_addr.s_addr == b.sin_addr.s_addr;
+    }
+    else if (addr.sa_family == AF_INET6) {
+        const sockaddr_in6& a = (const sockaddr_in6&)addr;
+        const sockaddr_in6& b = (const sockaddr_in6&)_serverAddr;
+        return a.sin6_port == b.sin6_port && 
+            memcmp(&a.sin6_addr, &b.sin6_addr, sizeof(a.sin6_addr)) == 0;
+    }
+    return false;
+}
+
+void VoterClient::consumePacket(const uint8_t* buf, unsigned bufLen, 
+    const sockaddr& peerAddr, uint32_t stampMs) {
+    _processReceivedPacket(buf, bufLen, peerAddr, stampMs);
 }
 
 void VoterClient::consume(const Message& m) {   
     if (m.isVoice()) {
-        if (_client.isPeerTrusted()) 
-            _client.sendAudio(0xff, m.body(), m.size());
+        const uint8_t* body = m.body();
+        unsigned bodyLen = m.size();
+        uint8_t coded[160];
+        const bool adpcm = isUplinkAdpcm() && bodyLen == 160;
+        if (bodyLen == 160) {
+            int16_t pcm8[160];
+            _tc.decode(m.body(), 160, pcm8, 160);
+            // The RSSI estimate and the tone detector want the raw 
+            // discriminator audio (before the CTCSS is filtered out)
+            _rssi.update(pcm8, 160);
+            if (_toneDetector.isActive())
+                _detectTones(pcm8, 160);
+            if (_conditioner.isActive())
+                _conditioner.process(pcm8, 160);
+            if (adpcm) {
+                bodyLen = _adpcm.encode(pcm8, 160, coded, sizeof(coded));
+                body = coded;
+            }
+            else if (_conditioner.isActive()) {
+                _tc.encode(pcm8, 160, coded, 160);
+                body = coded;
+            }
+        }
+        // Only audio with the right access tone goes out
+        if (_toneGate && !_toneDetector.isCtcssGateOpen())
+            return;
+        if (_client.isPeerTrusted())
+            _sendAudio(adpcm ? voter::PAYLOAD_ADPCM : voter::PAYLOAD_ULAW, 
+                body, bodyLen);
+    }
+}
+
+void VoterClient::_sendAudio(uint16_t payloadType, const uint8_t* body, 
+    unsigned bodyLen) {
+
+    // The VoterPeer looks after the session (auth and keepalives) but 
+    // the audio packets are built here, signed with the cached digest
+    const uint32_t digest = _auth.getOutboundDigest();
+    if (!_sockFd || !digest || 
+        voter::HEADER_SIZE + 1 + bodyLen > OutboundScheduler::MAX_PACKET_SIZE)
+        return;
+
+    uint8_t packet[OutboundScheduler::MAX_PACKET_SIZE];
+    if (!_writeHeader(packet, digest, payloadType))
+        return;
+    packet[voter::HEADER_SIZE] = _rssi.getRssi();
+    memcpy(packet + voter::HEADER_SIZE + 1, body, bodyLen);
+
+    _scheduler.submit(OutboundScheduler::AUDIO, packet, 
+        voter::HEADER_SIZE + 1 + bodyLen, (const sockaddr&)_serverAddr, _clock.time());
+}
+
+void VoterClient::_sendProbe() {
+
+    const uint32_t digest = _auth.getOutboundDigest();
+    if (!_sockFd || !digest || !_client.isPeerTrusted())
+        return;
+
+    uint8_t packet[voter::HEADER_SIZE + RttProbe::PAYLOAD_SIZE];
+    if (!_writeHeader(packet, digest, voter::PAYLOAD_PING) ||
+        _probe.makeProbe(_clock.time(), packet + voter::HEADER_SIZE) == 0)
+        return;
+
+    _scheduler.submit(OutboundScheduler::CONTROL, packet, sizeof(packet), 
+        (const sockaddr&)_serverAddr, _clock.time());
+}
+
+bool VoterClient::_writeHeader(uint8_t* packet, uint32_t digest, 
+    uint16_t payloadType) {
+    // Packets are stamped in the server's timebase: UTC when the local 
+    // clock is disciplined, otherwise the server's time as estimated
+    // from its own packets. The local uptime would mean nothing to the
+    // server.
+    const uint32_t now = _clock.time();
+    uint64_t stampMs;
+    if (_utcValid)
+        stampMs = _utcMsAtZero + now;
+    else if (_serverTimeValid) {
+        const int64_t best = _lastServerWindowValid && 
+            _lastServerWindowMax > _serverWindowMax ? 
+            _lastServerWindowMax : _serverWindowMax;
+        const int64_t halfRtt = _rttStats.getCount() ? _rttStats.getLast() / 2 : 0;
+        stampMs = (uint64_t)(now + best + halfRtt);
+    }
+    else 
+        return false;
+    voter::writeHeader(packet, stampMs / 1000, (stampMs % 1000) * 1000000, 
+        _auth.getLocalChallenge(), digest, payloadType);
+    return true;
+}
+
+bool VoterClient::isUplinkAdpcm() const {
+#ifdef AMP_VOTER_SIM_ADPCM
+    return _uplinkCodec == CODEC_ADPCM || 
+        (_uplinkCodec == CODEC_AUTO && _serverAdpcm);
+#else
+    return false;
+#endif
+}
+
+void VoterClient::_detectTones(const int16_t* pcm, unsigned len) {
+    ToneDetector::Event events[4];
+    unsigned n = _toneDetector.process(pcm, len, events, 4);
+    for (unsigned i = 0; i < n; i++) {
+        if (_trace)
+            hotInfo(_log, _dlog, "Line %u tone event %d %u %c", _lineId, (int)events[i].kind,
+                events[i].freqTenths, events[i].digit ? events[i].digit : '-');
+        if (_toneEventLineId) {
+            ToneSignal s;
+            s.kind = events[i].kind;
+            s.digit = events[i].digit;
+            s.freqTenths = events[i].freqTenths;
+            s.lineId = _lineId;
+            MessageWrapper msg(Message::Type::SIGNAL, events[i].kind, sizeof(s), 
+                (const uint8_t*)&s, 0, _clock.time());
+            msg.setDest(_toneEventLineId, Message::UNKNOWN_CALL_ID);
+            _bus.consume(msg);
+        }
     }
 }
 
 bool VoterClient::run2() {   
+    // Inbound traffic on a shared socket is handled by the VoterMux
+    if (_mux)
+        return false;
     return _processInboundData();
 }
 
 void VoterClient::audioRateTick(uint32_t ms) {
     _client.audioRateTick(ms);
+    // Anything that couldn't go out immediately goes now, audio first
+    _scheduler.drain(_clock.time());
 }
 
 void VoterClient::oneSecTick() {
     _client.oneSecTick();    
+    _sendProbe();
 }
 
 void VoterClient::tenSecTick() {
     _client.tenSecTick();    
+    if (_trace && _rttStats.getCount()) {
+        _log.info("Line %u RTT min/mean/p95 %d/%d/%d ms, downlink mean/p95 %d/%d ms, uplink %d ms",
+            _lineId, _rttStats.getMin(), _rttStats.getMean(), _rttStats.getP95(),
+            _downlinkStats.getMean(), _downlinkStats.getP95(), getUplinkEstimate());
+    }
+}
+
+int VoterClient::setToneGate(bool on) {
+    if (on && _toneDetector.getCtcssCount() == 0) {
+        _log.error("Line %u tone gate needs a CTCSS tone", _lineId);
+        return -1;
+    }
+    _toneGate = on;
+    return 0;
+}
+
+void VoterClient::setUtcOffset(uint64_t utcMsAtZero) {
+    _utcMsAtZero = utcMsAtZero;
+    _utcValid = true;
+    _downlinkStats.reset();
+}
+
+int32_t VoterClient::getUplinkEstimate() const {
+    if (_rttStats.getCount() == 0 || _downlinkStats.getCount() == 0)
+        return -1;
+    int32_t up = _rttStats.getMean() - _downlinkStats.getMean();
+    return up < 0 ? 0 : up;
 }
 
 int VoterClient::getPolls(pollfd* fds, unsigned fdsCapacity) {
     if (fdsCapacity < 1) 
         return -1;
     int used = 0;
-    if (_sockFd) {
+    if (_sockFd && !_mux) {
         // We're only watching for receive events
         fds[used].fd = _sockFd;
         fds[used].events = POLLIN;
@@ -175,35 +384,140 @@ bool VoterClient::_processInboundData() {
         return false;
 
     // Check for new data on the socket
-    // ### TODO: MOVE TO CONFIG AREA
-    const unsigned readBufferSize = 2048;
-    uint8_t readBuffer[readBufferSize];
+    uint8_t readBuffer[VoterMux::READ_BUFFER_SIZE];
     struct sockaddr_storage peerAddr;
-    socklen_t peerAddrLen = sizeof(peerAddr);
-    int rc = recvfrom(_sockFd, readBuffer, readBufferSize, 0, (sockaddr*)&peerAddr, &peerAddrLen);
-    if (rc == 0) {
+    unsigned len = VoterMux::receive(_sockFd, readBuffer, VoterMux::READ_BUFFER_SIZE,
+        peerAddr, _log, _dlog);
+    if (len == 0)
         return false;
-    } 
-    else if (rc == -1 && errno == 11) {
-        return false;
-    } 
-    else if (rc > 0) {
-        _processReceivedPacket(readBuffer, rc, (const sockaddr&)peerAddr, _clock.time());
-        // Return back to be nice, but indicate that there might be more
-        return true;
-    } else {
-        // #### TODO: ERROR COUNTER
-        _log.error("Voter read error %d/%d", rc, errno);
-        return false;
-    }
+    _processReceivedPacket(readBuffer, len, (const sockaddr&)peerAddr, _clock.time());
+    // Return back to be nice, but indicate that there might be more
+    return true;
 }
 
 void VoterClient::_processReceivedPacket(
     const uint8_t* packet, unsigned packetLen,
     const sockaddr& peerAddr, uint32_t rxStampMs) {
+    if (voter::isValidHeader(packet, packetLen)) {
+        if (_auth.isInboundAuthentic(packet)) {
+            _auth.observeRemoteChallenge(packet);
+            const uint16_t pt = voter::getPayloadType(packet);
+            const bool audio = pt == voter::PAYLOAD_ULAW || 
+                pt == voter::PAYLOAD_ADPCM || pt == voter::PAYLOAD_NULAW;
+#ifdef AMP_VOTER_SIM_ADPCM
+            // The server's downlink codec is what AUTO follows
+            if (audio) {
+                const unsigned bodyLen = packetLen - voter::HEADER_SIZE;
+                _serverAdpcm = pt == voter::PAYLOAD_ADPCM && 
+                    (bodyLen == Transcoder_IMA_ADPCM::FRAME_SIZE ||
+                     bodyLen == Transcoder_IMA_ADPCM::FRAME_SIZE + 1);
+            }
+#endif
+            // The reply to our own probe isn't for the VoterPeer
+            if (_measureLatency(packet, packetLen, rxStampMs))
+                return;
+            if (_audioOutLineId)
+                _forwardAudio(packet, packetLen, rxStampMs);
+            // Audio has been dealt with and already checked, so there's
+            // nothing in it for the VoterPeer. The session traffic (auth, 
+            // keepalive, etc.) still goes through.
+            if (audio)
+                return;
+        } 
+        // Signed by someone else, so there's no need for the VoterPeer
+        // to look at it. Packets without a digest (i.e. the start of 
+        // the auth exchange) still go through.
+        else if (voter::getDigest(packet) != 0) {
+            _authRejectCount++;
+            return;
+        }
+    }
     _client.consumePacket(peerAddr, packet, packetLen);
 }
 
+void VoterClient::_forwardAudio(const uint8_t* packet, unsigned packetLen, 
+    uint32_t rxStampMs) {
+
+    const uint16_t pt = voter::getPayloadType(packet);
+    const uint8_t* body = packet + voter::HEADER_SIZE;
+    unsigned bodyLen = packetLen - voter::HEADER_SIZE;
+
+#ifdef AMP_VOTER_SIM_ADPCM
+    uint8_t ulaw[160];
+#endif
+    if (pt == voter::PAYLOAD_ULAW) {
+        // Some servers include the RSSI byte on downlink frames
+        if (bodyLen == 161) {
+            body++;
+            bodyLen--;
+        }
+        if (bodyLen != 160)
+            return;
+    }
+#ifdef AMP_VOTER_SIM_ADPCM
+    // The audio output takes u-law. A real server's ADPCM isn't in this
+    // layout, so the firmware drops it.
+    else if (pt == voter::PAYLOAD_ADPCM) {
+        if (bodyLen == Transcoder_IMA_ADPCM::FRAME_SIZE + 1) {
+            body++;
+            bodyLen--;
+        }
+        if (bodyLen != Transcoder_IMA_ADPCM::FRAME_SIZE)
+            return;
+        int16_t pcm8[160];
+        _adpcm.decode(body, bodyLen, pcm8, 160);
+        _tc.encode(pcm8, 160, ulaw, 160);
+        body = ulaw;
+        bodyLen = 160;
+    }
+#endif
+    else 
+        return;
+
+    MessageWrapper msg(Message::Type::AUDIO, 0, bodyLen, body, 0, rxStampMs);
+    msg.setDest(_audioOutLineId, Message::UNKNOWN_CALL_ID);
+    _bus.consume(msg);
+}
+
+bool VoterClient::_measureLatency(const uint8_t* packet, unsigned packetLen,
+    uint32_t rxStampMs) {
+
+    // The server stamps its packets with its (disciplined) time so the
+    // one-way delay falls out if our clock is disciplined too. 
+    if (_serverTimeObserver)
+        _serverTimeObserver(voter::getWrappedTimeMs(packet), rxStampMs, 
+            _rttStats.getCount() ? (uint32_t)_rttStats.getLast() : 0);
+    if (_utcValid) {
+        const uint64_t localMs = _utcMsAtZero + rxStampMs;
+        _downlinkStats.addSample((int32_t)(localMs - voter::getTimeMs(packet)));
+    }
+
+    // Server time minus local time, largest for the least delayed packet
+    // (see TickAligner, which does the same modulo the frame). Two 
+    // windows are kept so that drift is followed.
+    const int64_t sample = (int64_t)voter::getTimeMs(packet) - rxStampMs;
+    if (_serverWindowCount == 0 || sample > _serverWindowMax)
+        _serverWindowMax = sample;
+    _serverTimeValid = true;
+    if (++_serverWindowCount == SERVER_TIME_WINDOW) {
+        _lastServerWindowMax = _serverWindowMax;
+        _lastServerWindowValid = true;
+        _serverWindowCount = 0;
+    }
+
+    // Only the echo of the outstanding probe counts. Keepalives that 
+    // cross the probe and late replies to a lost one are ignored.
+    uint32_t rtt;
+    if (voter::getPayloadType(packet) != voter::PAYLOAD_PING ||
+        !_probe.isReply(packet + voter::HEADER_SIZE, packetLen - voter::HEADER_SIZE, 
+            rxStampMs, rtt))
+        return false;
+    _rttStats.addSample(rtt);
+    if (_trace)
+        hotInfo(_log, _dlog, "Line %u RTT %u ms", _lineId, rtt);
+    return true;
+}
+
 void VoterClient::_sendPacketToPeer(const uint8_t* b, unsigned len, 
     const sockaddr& peerAddr) {
 
@@ -212,17 +526,45 @@ void VoterClient::_sendPacketToPeer(const uint8_t* b, unsigned len,
     if (!_sockFd)
         return;
 
+    // Audio frames get priority, everything else is control traffic
+    OutboundScheduler::Class c = OutboundScheduler::CONTROL;
+    if (len >= voter::HEADER_SIZE) {
+        uint16_t pt = voter::getPayloadType(b);
+        if (pt == voter::PAYLOAD_ULAW || pt == voter::PAYLOAD_ADPCM || 
+            pt == voter::PAYLOAD_NULAW)
+            c = OutboundScheduler::AUDIO;
+    }
+    _scheduler.submit(c, b, len, peerAddr, _clock.time());
+}
+
+int VoterClient::_writePacket(const uint8_t* b, unsigned len, 
+    const sockaddr& peerAddr) {
+
+    if (!_sockFd)
+        return OutboundScheduler::SEND_FAILED;
+
     int rc = ::sendto(_sockFd, 
         b,
         len, 0, &peerAddr, getIPAddrSize(peerAddr));
+
     if (rc < 0) {
-        if (errno == 101) {
-            char temp[64];
-            formatIPAddrAndPort(peerAddr, temp, 64);
-            _log.error("Network is unreachable to %s", temp);
-        } else 
-            _log.error("Send error %d", errno);
+        // The stack is out of buffers, so try again on the next tick
+        if (errno == ENOBUFS || errno == EAGAIN || errno == EWOULDBLOCK)
+            return OutboundScheduler::SEND_BUSY;
+        // The address isn't formatted here since the record can't point 
+        // at a stack buffer, but the line identifies the server anyway.
+        if (errno == 101)
+            hotError(_log, _dlog, "Line %u network is unreachable", _lineId);
+        else 
+            hotError(_log, _dlog, "Line %u send error %d", _lineId, errno);
+        return OutboundScheduler::SEND_FAILED;
     }
+
+    // The probe's round trip starts when it actually goes out
+    if (len >= voter::HEADER_SIZE && voter::getPayloadType(b) == voter::PAYLOAD_PING)
+        _probe.sent(b + voter::HEADER_SIZE, len - voter::HEADER_SIZE, _clock.time());
+
+    return OutboundScheduler::SEND_OK;
 }
 
 
@@ -25,11 +25,23 @@
 #include "Message.h"
 #include "MessageConsumer.h"
 #include "VoterPeer.h"
+#include "Transcoder_G711_ULAW.h"
+#include "Transcoder_IMA_ADPCM.h"
+
+#include "RssiEstimator.h"
+#include "LatencyEstimator.h"
+#include "RttProbe.h"
+#include "OutboundScheduler.h"
+#include "VoterAuth.h"
+#include "AudioConditioner.h"
+#include "ToneDetector.h"
+#include "DeferredLog.h"
 
 namespace kc1fsz {
 
 class Log;
 class Clock;
+class VoterMux;
 
 class VoterClient : public Runnable2, public MessageConsumer {
 public:
@@ -50,6 +62,18 @@ public:
      */
     int open(const char* serverAddrAndPort);
 
+    /**
+     * Opens the line on a socket that is shared with other lines. The
+     * VoterMux takes care of receiving and routing inbound packets.
+     *
+     * @returns 0 if the open was successful.
+     */
+    int open(const char* serverAddrAndPort, VoterMux& mux);
+
+    /**
+     * Closes the line's own socket, or detaches the line from the 
+     * VoterMux that it was opened on.
+     */
     void close();
     
     void setClientPassword(const char* p);
@@ -58,6 +82,146 @@ public:
 
     void setTrace(bool a) { _trace = a; }
 
+    unsigned getLineId() const { return _lineId; }
+
+    /**
+     * Errors and traces on the packet/audio paths go here instead of 
+     * straight to the Log so that they don't stall the audio tick. Use 
+     * nullptr (the default) to log directly.
+     */
+    void setDeferredLog(DeferredLog* d) { _dlog = d; }
+
+    RssiEstimator& getRssiEstimator() { return _rssi; }
+    const RssiEstimator& getRssiEstimator() const { return _rssi; }
+
+    /**
+     * The filtering/AGC applied to outbound audio. Everything is 
+     * disabled by default.
+     */
+    AudioConditioner& getConditioner() { return _conditioner; }
+
+    /**
+     * CTCSS/DTMF detection on the outbound audio. Configure the tones
+     * to watch here.
+     */
+    ToneDetector& getToneDetector() { return _toneDetector; }
+
+    /**
+     * When enabled, audio is only sent to the server while one of the
+     * configured CTCSS tones is present (see 
+     * ToneDetector::isCtcssGateOpen()). Configure the tones first.
+     *
+     * @returns 0 on success, -1 if the gate was enabled without any 
+     * CTCSS tones (it would never open).
+     */
+    int setToneGate(bool on);
+
+    /**
+     * Tone detections are sent to this line as SIGNAL messages (see 
+     * ToneSignal). Use 0 (the default) to discard them.
+     */
+    void setToneEventLine(unsigned lineId) { _toneEventLineId = lineId; }
+
+    /**
+     * Audio received from the server is sent to this line (i.e. an
+     * AudioOutput). Use 0 (the default) to discard it.
+     */
+    void setAudioOutputLine(unsigned lineId) { _audioOutLineId = lineId; }
+
+    // ----- Codec --------------------------------------------------------------
+
+    enum UplinkCodec { 
+        CODEC_ULAW, 
+#ifdef AMP_VOTER_SIM_ADPCM
+        // Half the bandwidth of u-law, in a frame layout of this 
+        // project's own (see Transcoder_IMA_ADPCM) that only the 
+        // simulated server takes. So ADPCM only exists in the host 
+        // tools, which are built with AMP_VOTER_SIM_ADPCM.
+        CODEC_ADPCM, 
+        // Whatever the server uses on the downlink
+        CODEC_AUTO 
+#endif
+    };
+
+    void setUplinkCodec(UplinkCodec c) { _uplinkCodec = c; }
+
+    /**
+     * @returns true if audio is currently being sent as ADPCM.
+     */
+    bool isUplinkAdpcm() const;
+
+    // ----- Network latency ----------------------------------------------------
+
+    /**
+     * Tells the client that the local clock has been disciplined to UTC
+     * (i.e. by NTP or GPS) so that the one-way delay from the server can 
+     * be estimated from the timestamps in the server's packets. Outbound
+     * packets are then stamped with UTC. Otherwise they are stamped with
+     * the server's time as estimated from its packets, and nothing is
+     * sent until a server packet has arrived.
+     *
+     * @param utcMsAtZero The UTC time (ms since the epoch) at which the
+     * Clock read zero.
+     */
+    void setUtcOffset(uint64_t utcMsAtZero);
+
+    /**
+     * Round-trip time measured with ping probes (see RttProbe).
+     */
+    const LatencyEstimator& getRttStats() const { return _rttStats; }
+
+    /**
+     * One-way delay server->client. Only populated when setUtcOffset() 
+     * has been called.
+     */
+    const LatencyEstimator& getDownlinkStats() const { return _downlinkStats; }
+
+    /**
+     * @returns The estimated one-way delay client->server (mean RTT minus 
+     * mean downlink delay) or -1 if there isn't enough information.
+     */
+    int32_t getUplinkEstimate() const;
+
+    /**
+     * Called with the server's time stamp (modulo voter::TIME_WRAP_MS, 
+     * see voter::getWrappedTimeMs()), the local arrival time and
+     * the most recent round trip (0 if unknown) for every authentic 
+     * packet.
+     * Used to line the local audio tick up with the server (see 
+     * TickAligner).
+     */
+    void setServerTimeObserver(std::function<void(uint32_t serverMs, uint32_t rxMs, 
+        uint32_t rttMs)> f) { _serverTimeObserver = f; }
+
+    // ----- Outbound scheduling --------------------------------------------------
+
+    const OutboundScheduler& getScheduler() const { return _scheduler; }
+
+    // ----- Shared socket support ----------------------------------------------
+
+    /**
+     * @returns true if the address is the one this line is talking to.
+     */
+    bool isFromServer(const sockaddr& addr) const;
+
+    /**
+     * @returns The digest that the server will put on packets it sends
+     * to this session. This is fixed once the passwords are set.
+     */
+    uint32_t getExpectedDigest() const { return _auth.getInboundDigest(); }
+
+    /**
+     * @returns The number of inbound packets dropped because they carried
+     * somebody else's digest.
+     */
+    uint32_t getAuthRejectCount() const { return _authRejectCount; }
+
+    /**
+     * Used by the VoterMux to deliver a packet that belongs to this line.
+     */
+    void consumePacket(const uint8_t* buf, unsigned bufLen, 
+        const sockaddr& peerAddr, uint32_t stampMs);
+
     // ----- Line/MessageConsumer-----------------------------------------------------
 
     virtual void consume(const Message& m);
@@ -78,13 +242,22 @@ public:
 private:
 
     bool _processInboundData();
+    bool _measureLatency(const uint8_t* packet, unsigned packetLen, uint32_t rxStampMs);
+    void _sendProbe();
+    void _forwardAudio(const uint8_t* packet, unsigned packetLen, uint32_t rxStampMs);
+    void _detectTones(const int16_t* pcm, unsigned len);
     void _processReceivedPacket(const uint8_t* buf, unsigned bufLen, 
         const sockaddr& peerAddr, uint32_t stampMs);
+    bool _writeHeader(uint8_t* packet, uint32_t digest, uint16_t payloadType);
+    void _sendAudio(uint16_t payloadType, const uint8_t* body, unsigned bodyLen);
     void _sendPacketToPeer(const uint8_t* b, unsigned len, 
         const sockaddr& peerAddr);
+    int _writePacket(const uint8_t* b, unsigned len, 
+        const sockaddr& peerAddr);
 
     Log& _log;
     Clock& _clock;
+    DeferredLog* _dlog = nullptr;
     const unsigned _lineId;
     MessageConsumer& _bus;
     // The IP address family used for this connection. Either AF_INET
@@ -94,11 +267,44 @@ private:
     int _listenPort = 0;
     // The UDP socket on which IAX messages are received/sent
     int _sockFd = 0;
+    // When set the socket belongs to this VoterMux
+    VoterMux* _mux = nullptr;
     // Enables detailed network tracing
     bool _trace = false;
+    unsigned _audioOutLineId = 0;
+    unsigned _toneEventLineId = 0;
+    bool _toneGate = false;
+    UplinkCodec _uplinkCodec = CODEC_ULAW;
+    // The server's last audio frame was ADPCM
+    bool _serverAdpcm = false;
     sockaddr_storage _serverAddr;
+    // Session digests, computed once rather than per packet
+    VoterAuth _auth;
+    uint32_t _authRejectCount = 0;
+
+    RttProbe _probe;
+    bool _utcValid = false;
+    uint64_t _utcMsAtZero = 0;
+    // Server packets per estimation window of the server's time
+    static const unsigned SERVER_TIME_WINDOW = 64;
+    bool _serverTimeValid = false;
+    unsigned _serverWindowCount = 0;
+    int64_t _serverWindowMax = 0;
+    int64_t _lastServerWindowMax = 0;
+    bool _lastServerWindowValid = false;
+    LatencyEstimator _rttStats;
+    LatencyEstimator _downlinkStats;
+    std::function<void(uint32_t, uint32_t, uint32_t)> _serverTimeObserver;
+
+    // Everything outbound goes through here so that audio has priority
+    OutboundScheduler _scheduler;
 
     amp::VoterPeer _client;
+    RssiEstimator _rssi;
+    AudioConditioner _conditioner;
+    ToneDetector _toneDetector;
+    Transcoder_G711_ULAW _tc;
+    Transcoder_IMA_ADPCM _adpcm;
 };
 
 }
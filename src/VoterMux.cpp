@@ -0,0 +1,176 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PICO_BOARD
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <netinet/in.h>
+
+#include "kc1fsz-tools/Common.h"
+#include "kc1fsz-tools/NetUtils.h"
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/Clock.h"
+
+#include "VoterProto.h"
+#include "DeferredLog.h"
+#include "VoterClient.h"
+#include "VoterMux.h"
+
+namespace kc1fsz {
+
+VoterMux::VoterMux(Log& log, Clock& clock)
+:   _log(log),
+    _clock(clock) {
+}
+
+int VoterMux::open(short addrFamily) {
+
+    close();
+
+    int sockFd = socket(addrFamily, SOCK_DGRAM, 0);
+    if (sockFd < 0) {
+        _log.error("Unable to open shared Voter port (%d)", errno);
+        return -1;
+    }
+
+    int optval = 1;
+    if (setsockopt(sockFd, SOL_SOCKET, SO_REUSEADDR, (const char*)&optval, sizeof(optval)) < 0) {
+        _log.error("Voter setsockopt SO_REUSEADDR failed (%d)", errno);
+        ::close(sockFd);
+        return -1;
+    }
+
+    if (makeNonBlocking(sockFd) != 0) {
+        _log.error("open fcntl failed (%d)", errno);
+        ::close(sockFd);
+        return -1;
+    }
+
+    _sockFd = sockFd;
+    return 0;
+}
+
+void VoterMux::close() {
+    if (_sockFd)
+        ::close(_sockFd);
+    _sockFd = 0;
+}
+
+int VoterMux::addLine(VoterClient* line) {
+    if (_lineCount == MAX_LINES)
+        return -1;
+    _lines[_lineCount++] = line;
+    return 0;
+}
+
+int VoterMux::removeLine(VoterClient* line) {
+    for (unsigned i = 0; i < _lineCount; i++) {
+        if (_lines[i] == line) {
+            // Order doesn't matter to the dispatch
+            _lines[i] = _lines[--_lineCount];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+bool VoterMux::run2() {
+
+    if (!_sockFd)
+        return false;
+
+    uint8_t readBuffer[READ_BUFFER_SIZE];
+    struct sockaddr_storage peerAddr;
+    unsigned len = receive(_sockFd, readBuffer, READ_BUFFER_SIZE, peerAddr, _log, _dlog);
+    if (len == 0)
+        return false;
+    dispatch(readBuffer, len, (const sockaddr&)peerAddr, _clock.time());
+    // Return back to be nice, but indicate that there might be more
+    return true;
+}
+
+unsigned VoterMux::receive(int sockFd, uint8_t* buf, unsigned bufCapacity,
+    sockaddr_storage& peerAddr, Log& log, DeferredLog* dlog) {
+    socklen_t peerAddrLen = sizeof(peerAddr);
+    int rc = recvfrom(sockFd, buf, bufCapacity, 0, (sockaddr*)&peerAddr, &peerAddrLen);
+    if (rc > 0)
+        return rc;
+    if (rc < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        // #### TODO: ERROR COUNTER
+        hotError(log, dlog, "Voter read error %d/%d", rc, errno);
+    }
+    return 0;
+}
+
+int VoterMux::getPolls(pollfd* fds, unsigned fdsCapacity) {
+    if (fdsCapacity < 1)
+        return -1;
+    int used = 0;
+    if (_sockFd) {
+        fds[used].fd = _sockFd;
+        fds[used].events = POLLIN;
+        used++;
+    }
+    return used;
+}
+
+void VoterMux::dispatch(const uint8_t* packet, unsigned len,
+    const sockaddr& peerAddr, uint32_t stampMs) {
+
+    if (!voter::isValidHeader(packet, len)) {
+        _unmatchedCount++;
+        return;
+    }
+
+    const uint32_t digest = voter::getDigest(packet);
+    unsigned fromServerCount = 0;
+    VoterClient* fromServer = 0;
+
+    // The normal case: the digest identifies the session
+    for (unsigned i = 0; i < _lineCount; i++) {
+        if (_lines[i]->isFromServer(peerAddr)) {
+            if (digest != 0 && _lines[i]->getExpectedDigest() == digest) {
+                _lines[i]->consumePacket(packet, len, peerAddr, stampMs);
+                return;
+            }
+            fromServerCount++;
+            fromServer = _lines[i];
+        }
+    }
+
+    // Only one session talks to this server so let the session sort
+    // out whether the packet is valid.
+    if (fromServerCount == 1) {
+        fromServer->consumePacket(packet, len, peerAddr, stampMs);
+    }
+    // A packet without a digest can't be attributed, so every session
+    // on that server gets a look at it.
+    else if (fromServerCount > 1 && digest == 0) {
+        for (unsigned i = 0; i < _lineCount; i++)
+            if (_lines[i]->isFromServer(peerAddr))
+                _lines[i]->consumePacket(packet, len, peerAddr, stampMs);
+    }
+    else {
+        _unmatchedCount++;
+    }
+}
+
+}
@@ -0,0 +1,121 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+#include <sys/socket.h>
+
+#include "Runnable2.h"
+
+namespace kc1fsz {
+
+class Log;
+class Clock;
+class VoterClient;
+class DeferredLog;
+
+/**
+ * Owns a single UDP socket that is shared by several VoterClient lines
+ * (i.e. several receivers on the same board). Inbound packets are
+ * demultiplexed to the right line using the server address and then
+ * the VOTER digest, which is unique per session because each line
+ * uses its own challenge.
+ */
+class VoterMux : public Runnable2 {
+public:
+
+    static const unsigned MAX_LINES = 4;
+    // Larger than any VOTER packet
+    static const unsigned READ_BUFFER_SIZE = 2048;
+
+    VoterMux(Log& log, Clock& clock);
+
+    /**
+     * Opens the shared socket.
+     *
+     * @param addrFamily AF_INET or AF_INET6
+     * @returns 0 if the open was successful.
+     */
+    int open(short addrFamily);
+
+    void close();
+
+    int getFd() const { return _sockFd; }
+
+    /**
+     * Called by VoterClient::open() when a line is attached.
+     * @returns 0 on success, -1 if the line table is full.
+     */
+    int addLine(VoterClient* line);
+
+    /**
+     * Called by VoterClient::close() when a line is detached. Packets
+     * for that line are counted as unmatched from then on.
+     * @returns 0 on success, -1 if the line wasn't attached.
+     */
+    int removeLine(VoterClient* line);
+
+    unsigned getLineCount() const { return _lineCount; }
+
+    /**
+     * @returns The number of inbound packets that could not be
+     * matched to any line.
+     */
+    uint32_t getUnmatchedCount() const { return _unmatchedCount; }
+
+    /**
+     * Read errors go here rather than straight to the Log. Use nullptr
+     * (the default) to log directly.
+     */
+    void setDeferredLog(DeferredLog* d) { _dlog = d; }
+
+    /**
+     * Hands an inbound packet to the line it belongs to. Called from 
+     * run2() for each packet read (and by the benchmarks directly).
+     */
+    void dispatch(const uint8_t* packet, unsigned len, const sockaddr& peerAddr,
+        uint32_t stampMs);
+
+    /**
+     * Reads one packet from a non-blocking socket. This is the receive
+     * path for the shared socket and for lines that have a socket of
+     * their own.
+     *
+     * @returns The length of the packet, or 0 if there was nothing to 
+     * read. Read errors are logged and also return 0.
+     */
+    static unsigned receive(int sockFd, uint8_t* buf, unsigned bufCapacity,
+        sockaddr_storage& peerAddr, Log& log, DeferredLog* dlog);
+
+    // ----- Runnable -------------------------------------------------------
+
+    virtual bool run2();
+
+    virtual int getPolls(pollfd* fds, unsigned fdsCapacity);
+
+private:
+
+    Log& _log;
+    Clock& _clock;
+    DeferredLog* _dlog = nullptr;
+    int _sockFd = 0;
+    VoterClient* _lines[MAX_LINES];
+    unsigned _lineCount = 0;
+    uint32_t _unmatchedCount = 0;
+};
+
+}
@@ -0,0 +1,47 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstring>
+
+#include "VoterProto.h"
+
+namespace kc1fsz {
+namespace voter {
+
+static uint32_t update(uint32_t crc, const char* s) {
+    while (s && *s) {
+        crc ^= (uint8_t)*s++;
+        for (unsigned i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+    }
+    return crc;
+}
+
+void writeHeader(uint8_t* packet, uint32_t sec, uint32_t nsec, 
+    const char* challenge, uint32_t digest, uint16_t payloadType) {
+    pack32(packet + OFFSET_SEC, sec);
+    pack32(packet + OFFSET_NSEC, nsec);
+    strncpy((char*)packet + OFFSET_CHALLENGE, challenge, CHALLENGE_SIZE);
+    pack32(packet + OFFSET_DIGEST, digest);
+    pack16(packet + OFFSET_PAYLOAD_TYPE, payloadType);
+}
+
+uint32_t crc32(const char* challenge, const char* password) {
+    return ~update(update(0xffffffff, challenge), password);
+}
+
+}
+}
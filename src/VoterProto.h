@@ -0,0 +1,124 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace kc1fsz {
+
+/**
+ * Helpers for looking inside of (and building) VOTER packets without 
+ * going through amp::VoterPeer. The header layout (all big-endian) is:
+ *
+ *   0  vtime_sec      (4)
+ *   4  vtime_nsec     (4)
+ *   8  challenge      (10)
+ *  18  digest         (4)
+ *  22  payload_type   (2)
+ *  24  payload ...
+ */
+namespace voter {
+
+const unsigned HEADER_SIZE = 24;
+const unsigned CHALLENGE_SIZE = 10;
+
+// The audio frame length
+const uint32_t FRAME_MS = 20;
+// Server times are passed around modulo this so that they fit in 32 
+// bits. Unlike 2^32 it is a multiple of FRAME_MS, so the position within
+// the frame survives the wrap.
+const uint32_t TIME_WRAP_MS = FRAME_MS << 26;
+
+const unsigned OFFSET_SEC = 0;
+const unsigned OFFSET_NSEC = 4;
+const unsigned OFFSET_CHALLENGE = 8;
+const unsigned OFFSET_DIGEST = 18;
+const unsigned OFFSET_PAYLOAD_TYPE = 22;
+
+const uint16_t PAYLOAD_NONE = 0;
+const uint16_t PAYLOAD_ULAW = 1;
+const uint16_t PAYLOAD_GPS = 2;
+const uint16_t PAYLOAD_ADPCM = 3;
+const uint16_t PAYLOAD_NULAW = 4;
+const uint16_t PAYLOAD_PING = 5;
+
+inline uint32_t unpack32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+        ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+inline uint16_t unpack16(const uint8_t* p) {
+    return ((uint16_t)p[0] << 8) | (uint16_t)p[1];
+}
+
+inline void pack32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+inline void pack16(uint8_t* p, uint16_t v) {
+    p[0] = v >> 8; p[1] = v;
+}
+
+inline bool isValidHeader(const uint8_t* packet, unsigned len) {
+    return len >= HEADER_SIZE;
+}
+
+inline uint32_t getDigest(const uint8_t* packet) {
+    return unpack32(packet + OFFSET_DIGEST);
+}
+
+inline uint16_t getPayloadType(const uint8_t* packet) {
+    return unpack16(packet + OFFSET_PAYLOAD_TYPE);
+}
+
+inline uint32_t getTimeSec(const uint8_t* packet) {
+    return unpack32(packet + OFFSET_SEC);
+}
+
+inline uint32_t getTimeNsec(const uint8_t* packet) {
+    return unpack32(packet + OFFSET_NSEC);
+}
+
+/**
+ * @returns The packet's time stamp in ms (i.e. since the epoch).
+ */
+inline uint64_t getTimeMs(const uint8_t* packet) {
+    return (uint64_t)getTimeSec(packet) * 1000 + getTimeNsec(packet) / 1000000;
+}
+
+/**
+ * @returns The packet's time stamp in ms, modulo TIME_WRAP_MS.
+ */
+inline uint32_t getWrappedTimeMs(const uint8_t* packet) {
+    return (uint32_t)(getTimeMs(packet) % TIME_WRAP_MS);
+}
+
+/**
+ * Fills in a header. The challenge is a null-terminated string that is
+ * null-padded (or cut) to CHALLENGE_SIZE.
+ */
+void writeHeader(uint8_t* packet, uint32_t sec, uint32_t nsec, 
+    const char* challenge, uint32_t digest, uint16_t payloadType);
+
+/**
+ * The VOTER authenticator: a standard CRC-32 over the challenge
+ * followed by the password (both null-terminated strings).
+ */
+uint32_t crc32(const char* challenge, const char* password);
+
+}
+}
@@ -0,0 +1,128 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstring>
+
+#include "kc1fsz-tools/Log.h"
+
+#include "AudioOutput.h"
+#include "WavAudioDriver.h"
+
+namespace kc1fsz {
+
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    put16(p, v & 0xffff);
+    put16(p + 2, v >> 16);
+}
+
+WavAudioDriver::WavAudioDriver(Log& log, AudioOutput& source)
+:   _log(log),
+    _source(source) {
+}
+
+WavAudioDriver::~WavAudioDriver() {
+    close();
+}
+
+int WavAudioDriver::open(const char* path) {
+    close();
+    if (strcmp(path, "-") == 0) {
+        _file = stdout;
+        _seekable = false;
+    } else {
+        _file = fopen(path, "wb");
+        if (!_file) {
+            _log.error("Unable to open %s", path);
+            return -1;
+        }
+        _seekable = true;
+    }
+    _dataBytes = 0;
+    // The sizes are patched on close (when possible)
+    _writeHeader(0xffffffff - 36);
+    return 0;
+}
+
+void WavAudioDriver::close() {
+    if (!_file)
+        return;
+    if (_seekable) {
+        fseek(_file, 0, SEEK_SET);
+        _writeHeader(_dataBytes);
+        fclose(_file);
+    } else {
+        fflush(_file);
+    }
+    _file = 0;
+}
+
+void WavAudioDriver::_writeHeader(uint32_t dataBytes) {
+    uint8_t h[44];
+    memcpy(h, "RIFF", 4);
+    put32(h + 4, 36 + dataBytes);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put32(h + 16, 16);
+    // PCM, mono, 8 kHz, 16 bits
+    put16(h + 20, 1);
+    put16(h + 22, 1);
+    put32(h + 24, 8000);
+    put32(h + 28, 8000 * 2);
+    put16(h + 32, 2);
+    put16(h + 34, 16);
+    memcpy(h + 36, "data", 4);
+    put32(h + 40, dataBytes);
+    fwrite(h, 1, sizeof(h), _file);
+}
+
+void WavAudioDriver::audioRateTick(uint32_t) {
+
+    if (!_file)
+        return;
+
+    // Add/remove a sample now and then to model a local clock error
+    unsigned len = BLOCK_SIZE;
+    _errorAcc += _clockErrorPpm * (int32_t)BLOCK_SIZE;
+    if (_errorAcc >= 1000000) {
+        len++;
+        _errorAcc -= 1000000;
+    } else if (_errorAcc <= -1000000) {
+        len--;
+        _errorAcc += 1000000;
+    }
+
+    int16_t pcm[BLOCK_SIZE + 1];
+    _source.render(pcm, len);
+
+    // WAV is little-endian
+    uint8_t out[(BLOCK_SIZE + 1) * 2];
+    for (unsigned i = 0; i < len; i++)
+        put16(out + i * 2, (uint16_t)pcm[i]);
+    fwrite(out, 2, len, _file);
+    _dataBytes += len * 2;
+}
+
+void WavAudioDriver::tenSecTick() {
+    const AudioOutput::Stats& s = _source.getStats();
+    _log.info("WAV out %u bytes, underruns %u, overruns %u, drift %d ppm",
+        _dataBytes, s.underruns, s.overruns, _source.getDriftPpm());
+}
+
+}
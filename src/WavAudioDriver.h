@@ -0,0 +1,77 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+
+#include "Runnable2.h"
+
+namespace kc1fsz {
+
+class Log;
+class AudioOutput;
+
+/**
+ * The host-side stand-in for the PWM output. One block of audio is
+ * pulled from the AudioOutput on every audio tick and appended to a
+ * 16-bit mono 8 kHz WAV file. Use "-" to write to stdout (i.e. to pipe
+ * into aplay/sox).
+ *
+ * The driver can be told to run fast or slow by some number of parts
+ * per million to exercise the drift compensation.
+ */
+class WavAudioDriver : public Runnable2 {
+public:
+
+    static const unsigned BLOCK_SIZE = 160;
+
+    WavAudioDriver(Log& log, AudioOutput& source);
+    ~WavAudioDriver();
+
+    /**
+     * @returns 0 on success
+     */
+    int open(const char* path);
+
+    void close();
+
+    /**
+     * Simulates a local sample clock that is off by the given amount.
+     */
+    void setClockErrorPpm(int32_t ppm) { _clockErrorPpm = ppm; }
+
+    // ----- Runnable -------------------------------------------------------
+
+    virtual void audioRateTick(uint32_t tickTimeMs);
+    virtual void tenSecTick();
+
+private:
+
+    void _writeHeader(uint32_t dataBytes);
+
+    Log& _log;
+    AudioOutput& _source;
+    FILE* _file = 0;
+    bool _seekable = false;
+    uint32_t _dataBytes = 0;
+    int32_t _clockErrorPpm = 0;
+    // Accumulated fractional samples (in millionths)
+    int32_t _errorAcc = 0;
+};
+
+}
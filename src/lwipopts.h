@@ -13,14 +13,14 @@
 #ifndef LWIP_SOCKET
 #define LWIP_SOCKET                 0
 #endif
-#if PICO_CYW43_ARCH_POLL
-#define MEM_LIBC_MALLOC             1
-#else
-// MEM_LIBC_MALLOC is incompatible with non polling versions
+// lwIP uses its own fixed-size heap (MEM_SIZE) and pools rather than
+// the C library heap. Every outbound UDP datagram allocates a PBUF_RAM
+// so using malloc here would put the C heap on the per-packet path.
+// (MEM_LIBC_MALLOC is also incompatible with non polling versions)
 #define MEM_LIBC_MALLOC             0
-#endif
 #define MEM_ALIGNMENT               4
-#define MEM_SIZE                    4000
+// Enough room for a few queued outbound datagrams plus DHCP/ARP traffic
+#define MEM_SIZE                    8000
 #define MEMP_NUM_TCP_SEG            32
 #define MEMP_NUM_ARP_QUEUE          10
 #define PBUF_POOL_SIZE              24
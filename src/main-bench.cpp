@@ -0,0 +1,643 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * voter-bench: host micro-benchmarks for each step of the per-packet 
+ * and per-frame paths, plus an SNR check of the codecs. The results are
+ * written as JSON so that runs can be compared between commits:
+ *
+ *   voter-bench > before.json
+ *   voter-bench --filter ulaw --reps 500
+ *
+ * Notes:
+ * - The socket benchmarks use the simulated network (micro-ip/impl-sim)
+ *   so they measure the shim and the copies, not lwIP.
+ * - The VoterClient benchmarks send on the simulated network, which
+ *   discards the packets on delivery.
+ * - "allocs" is the number of operator new calls during a benchmark 
+ *   (see HeapGuard). It should always be zero.
+ */
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include "kc1fsz-tools/Log.h"
+
+// amp-core
+#include "Message.h"
+#include "MessageConsumer.h"
+#include "SimpleRouter.h"
+#include "VoterPeer.h"
+#include "Transcoder_G711_ULAW.h"
+
+#include "simnet.h"
+#include "Bench.h"
+#include "SimClock.h"
+#include "VoterProto.h"
+#include "VoterAuth.h"
+#include "VoterClient.h"
+#include "VoterMux.h"
+#include "SignalGenerator.h"
+#include "AudioConditioner.h"
+#include "ToneDetector.h"
+#include "RssiEstimator.h"
+#include "AudioOutput.h"
+#include "Transcoder_IMA_ADPCM.h"
+#include "StaticTaskGraph.h"
+#include "TelemetryExporter.h"
+#include "HeapGuard.h"
+#include "DeferredLog.h"
+#include "TickAligner.h"
+
+#define LINE_ID_VOTER (24)
+#define LINE_ID_SINK (30)
+
+using namespace std;
+using namespace kc1fsz;
+
+namespace {
+
+class NullConsumer : public MessageConsumer {
+public:
+    virtual void consume(const Message& m) { Bench::keep(&m); }
+};
+
+void pack32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+/**
+ * A downlink audio packet as the server would send it.
+ */
+unsigned makeServerPacket(uint8_t* p, const char* serverChallenge, uint32_t digest,
+    const uint8_t* ulaw) {
+    memset(p, 0, voter::HEADER_SIZE);
+    pack32(p + voter::OFFSET_SEC, 1000);
+    memcpy(p + voter::OFFSET_CHALLENGE, serverChallenge, voter::CHALLENGE_SIZE);
+    pack32(p + voter::OFFSET_DIGEST, digest);
+    p[voter::OFFSET_PAYLOAD_TYPE + 1] = voter::PAYLOAD_ULAW;
+    memcpy(p + voter::HEADER_SIZE, ulaw, 160);
+    return voter::HEADER_SIZE + 160;
+}
+
+void makeSpeechLikeFrame(int16_t* pcm, unsigned n, unsigned seed) {
+    uint32_t r = seed * 2654435761u + 1;
+    for (unsigned i = 0; i < n; i++) {
+        r = r * 1664525u + 1013904223u;
+        pcm[i] = (int16_t)(6000.0 * sin(2.0 * 3.14159265358979 * 440.0 * i / 8000.0) +
+            ((int32_t)(r >> 16) - 32768) / 16);
+    }
+}
+
+// Stand-ins for the firmware's main loop tasks, with almost nothing in
+// the hooks so that the dispatch cost is what gets measured. Like the
+// real tasks, most of them only implement one or two hooks.
+
+class SocketTask : public Runnable2 {
+public:
+    uint32_t n = 0;
+    virtual bool run2() { n++; return false; }
+    virtual int getPolls(pollfd*, unsigned) { return 0; }
+};
+
+class BusyTask : public Runnable2 {
+public:
+    uint32_t n = 0;
+    virtual bool run2() { return (++n & 7) == 0; }
+};
+
+class TickTask : public Runnable2 {
+public:
+    uint32_t n = 0;
+    virtual void audioRateTick(uint32_t tickTimeMs) { n += tickTimeMs; }
+};
+
+class StatsTask : public Runnable2 {
+public:
+    uint32_t n = 0;
+    virtual void tenSecTick() { n++; }
+};
+
+/**
+ * One pass of an array-based event loop, kept out of line so that the
+ * calls stay virtual.
+ */
+[[gnu::noinline]] bool virtualPass(Runnable2** tasks, unsigned count) {
+    bool busy = false;
+    for (unsigned i = 0; i < count; i++)
+        if (tasks[i]->run2())
+            busy = true;
+    return busy;
+}
+
+[[gnu::noinline]] void virtualTickPass(Runnable2** tasks, unsigned count, 
+    uint32_t tickMs) {
+    for (unsigned i = 0; i < count; i++)
+        tasks[i]->audioRateTick(tickMs);
+    for (unsigned i = 0; i < count; i++)
+        tasks[i]->oneSecTick();
+    for (unsigned i = 0; i < count; i++)
+        tasks[i]->tenSecTick();
+}
+
+/**
+ * Just the audio tick, which is the one that happens every 20ms.
+ */
+[[gnu::noinline]] void virtualAudioTickPass(Runnable2** tasks, unsigned count, 
+    uint32_t tickMs) {
+    for (unsigned i = 0; i < count; i++)
+        tasks[i]->audioRateTick(tickMs);
+}
+
+/**
+ * SNR of the u-law and ADPCM round trips on two seconds of a speech-like
+ * signal (continuous across frames, unlike the benchmark input).
+ */
+void codecSnr(double scale, double& ulawSnr, double& adpcmSnr) {
+    Transcoder_G711_ULAW tc;
+    Transcoder_IMA_ADPCM enc, dec;
+    double sig = 0, errU = 0, errA = 0;
+    uint32_t r = 12345;
+    for (unsigned f = 0; f < 100; f++) {
+        int16_t in[160], outU[160], outA[160];
+        for (unsigned i = 0; i < 160; i++) {
+            const double t = (f * 160 + i) / 8000.0;
+            r = r * 1664525u + 1013904223u;
+            const double v = 6000.0 * sin(2.0 * M_PI * 440.0 * t) +
+                3000.0 * sin(2.0 * M_PI * 1230.0 * t) * sin(2.0 * M_PI * 3.0 * t) +
+                ((int32_t)(r >> 16) - 32768) / 16.0;
+            in[i] = (int16_t)(v * scale);
+        }
+        uint8_t u[160], a[Transcoder_IMA_ADPCM::FRAME_SIZE];
+        tc.encode(in, 160, u, 160);
+        tc.decode(u, 160, outU, 160);
+        enc.encode(in, 160, a, sizeof(a));
+        dec.decode(a, sizeof(a), outA, 160);
+        for (unsigned i = 0; i < 160; i++) {
+            sig += (double)in[i] * in[i];
+            errU += (double)(in[i] - outU[i]) * (in[i] - outU[i]);
+            errA += (double)(in[i] - outA[i]) * (in[i] - outA[i]);
+        }
+    }
+    ulawSnr = 10.0 * log10(sig / (errU > 0 ? errU : 1));
+    adpcmSnr = 10.0 * log10(sig / (errA > 0 ? errA : 1));
+}
+
+}
+
+int main(int argc, const char** argv) {
+
+    unsigned reps = 200;
+    unsigned warmup = 20;
+    const char* filter = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)
+            reps = strtoul(argv[++i], 0, 10);
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = strtoul(argv[++i], 0, 10);
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else {
+            fprintf(stderr, "usage: voter-bench [--reps N] [--warmup N] [--filter TEXT]\n");
+            return 1;
+        }
+    }
+
+    SimClock clock;
+    clock.set(1000);
+    Log log;
+    Bench bench(warmup, reps);
+    bool first = true;
+
+    printf("{\"tool\":\"voter-bench\",\"tsc\":%s,\"results\":[\n", 
+        BENCH_HAS_TSC ? "true" : "false");
+
+    auto report = [&](const char* name, auto&& f) {
+        if (filter && !strstr(name, filter))
+            return;
+        // Every path measured here runs after startup on the Pico, so
+        // anything other than zero allocations is a bug
+        const uint32_t allocsBefore = HeapGuard::getAllocCount();
+        Bench::Result r = bench.run(name, f);
+        r.allocs = HeapGuard::getAllocCount() - allocsBefore;
+        if (!first)
+            printf(",\n");
+        first = false;
+        Bench::writeJson(stdout, r);
+        fflush(stdout);
+    };
+
+    // ----- Common inputs -----------------------------------------------------
+
+    Transcoder_G711_ULAW tc;
+    int16_t pcm[160];
+    makeSpeechLikeFrame(pcm, 160, 1);
+    uint8_t ulaw[160];
+    tc.encode(pcm, 160, ulaw, 160);
+
+    const char* serverChallenge = "1234567890";
+    sockaddr_storage serverAddr;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    sockaddr_in& sa = (sockaddr_in&)serverAddr;
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(1667);
+    inet_pton(AF_INET, "52.8.247.112", &sa.sin_addr);
+
+    NullConsumer sink;
+    SimpleRouter router;
+    router.addRoute(&sink, LINE_ID_SINK);
+
+    // ----- Codec -------------------------------------------------------------
+
+    report("ulaw_encode_160", [&]() {
+        uint8_t out[160];
+        tc.encode(pcm, 160, out, 160);
+        Bench::keep(out);
+    });
+
+    report("ulaw_decode_160", [&]() {
+        int16_t out[160];
+        tc.decode(ulaw, 160, out, 160);
+        Bench::keep(out);
+    });
+
+    Transcoder_IMA_ADPCM adpcm;
+    report("adpcm_encode_160", [&]() {
+        uint8_t out[Transcoder_IMA_ADPCM::FRAME_SIZE];
+        adpcm.encode(pcm, 160, out, sizeof(out));
+        Bench::keep(out);
+    });
+
+    uint8_t adpcmFrame[Transcoder_IMA_ADPCM::FRAME_SIZE];
+    adpcm.encode(pcm, 160, adpcmFrame, sizeof(adpcmFrame));
+    report("adpcm_decode_160", [&]() {
+        int16_t out[160];
+        adpcm.decode(adpcmFrame, sizeof(adpcmFrame), out, 160);
+        Bench::keep(out);
+    });
+
+    // ----- Authentication ----------------------------------------------------
+
+    // What it costs when the digest is computed for every packet
+    report("auth_crc32", [&]() {
+        uint32_t d = voter::crc32(serverChallenge, "parrot0");
+        Bench::keep(&d);
+    });
+
+    VoterAuth auth;
+    auth.setLocalChallenge("abcdefghij");
+    auth.setLocalPassword("client0");
+    auth.setRemotePassword("parrot0");
+    uint8_t authPacket[voter::HEADER_SIZE + 160];
+    makeServerPacket(authPacket, serverChallenge, auth.getInboundDigest(), ulaw);
+
+    report("auth_validate", [&]() {
+        bool ok = auth.isInboundAuthentic(authPacket);
+        Bench::keep(&ok);
+    });
+
+    // ----- VoterPeer ---------------------------------------------------------
+
+    amp::VoterPeer peer(true);
+    peer.init(&clock, &log);
+    peer.setSink([](const sockaddr&, const uint8_t* data, unsigned) {
+        Bench::keep(data);
+    });
+    peer.setPeerAddr(serverAddr);
+    peer.setLocalChallenge("abcdefghij");
+    peer.setLocalPassword("client0");
+    peer.setRemotePassword("parrot0");
+    uint8_t peerPacket[voter::HEADER_SIZE + 160];
+    unsigned peerPacketLen = makeServerPacket(peerPacket, serverChallenge,
+        voter::crc32("abcdefghij", "parrot0"), ulaw);
+
+    report("voterpeer_consume_packet", [&]() {
+        peer.consumePacket((const sockaddr&)serverAddr, peerPacket, peerPacketLen);
+    });
+
+    // ----- VoterClient -------------------------------------------------------
+
+    // The line sends on the simulated network. Nothing is bound at the 
+    // server address so the packets are discarded on delivery.
+    simnet_reset(1);
+    simnet_set_link(0, 0, 0);
+    VoterClient client(log, clock, LINE_ID_VOTER, router);
+    client.setClientPassword("client0");
+    client.setServerPassword("parrot0");
+    client.setAudioOutputLine(LINE_ID_SINK);
+    client.open("52.8.247.112:1667");
+    uint8_t clientPacket[voter::HEADER_SIZE + 160];
+    unsigned clientPacketLen = makeServerPacket(clientPacket, serverChallenge,
+        client.getExpectedDigest(), ulaw);
+
+    // A keepalive from the server completes the session, so that the 
+    // uplink frames below go all the way to sendto()
+    uint8_t keepalive[voter::HEADER_SIZE];
+    memcpy(keepalive, clientPacket, voter::HEADER_SIZE);
+    keepalive[voter::OFFSET_PAYLOAD_TYPE + 1] = voter::PAYLOAD_NONE;
+    client.consumePacket(keepalive, sizeof(keepalive), (const sockaddr&)serverAddr, 
+        clock.time());
+
+    // Authenticated downlink audio: digest check, latency, forward to the
+    // audio output line
+    report("client_process_received", [&]() {
+        client.consumePacket(clientPacket, clientPacketLen, 
+            (const sockaddr&)serverAddr, clock.time());
+    });
+
+    // Somebody else's session on a shared socket
+    uint8_t foreignPacket[voter::HEADER_SIZE + 160];
+    unsigned foreignPacketLen = makeServerPacket(foreignPacket, serverChallenge,
+        client.getExpectedDigest() ^ 1, ulaw);
+    report("client_reject_foreign", [&]() {
+        client.consumePacket(foreignPacket, foreignPacketLen, 
+            (const sockaddr&)serverAddr, clock.time());
+    });
+
+    // The whole uplink path for one line and one frame (decode, RSSI,
+    // tones, conditioning, encode, build the packet, send). This is the
+    // per-line cost.
+    client.getConditioner().setHighPass(true);
+    client.getConditioner().setAgc(true);
+    client.getToneDetector().addCtcssTone(1000);
+    client.getToneDetector().setDtmfEnabled(true);
+    MessageWrapper uplinkMsg(Message::Type::AUDIO, 0, 160, ulaw, 0, 0);
+    uplinkMsg.setDest(LINE_ID_VOTER, Message::UNKNOWN_CALL_ID);
+    report("client_uplink_frame", [&]() {
+        client.consume(uplinkMsg);
+        simnet_advance(clock.time());
+    });
+    client.close();
+
+    // ----- VoterMux ----------------------------------------------------------
+
+    // 1, 2 and 4 lines on one shared socket. The dispatch goes to the 
+    // last line attached (the longest search) and the uplink is one frame
+    // on every line, so the per-frame cost of a board with N receivers.
+    {
+        VoterMux mux(log, clock);
+        mux.open(AF_INET);
+        VoterClient line0(log, clock, LINE_ID_VOTER, router);
+        VoterClient line1(log, clock, LINE_ID_VOTER + 1, router);
+        VoterClient line2(log, clock, LINE_ID_VOTER + 2, router);
+        VoterClient line3(log, clock, LINE_ID_VOTER + 3, router);
+        VoterClient* lines[] = { &line0, &line1, &line2, &line3 };
+        const char* clientPasswords[] = { "client0", "client1", "client2", "client3" };
+        const unsigned lineCounts[] = { 1, 2, 4 };
+
+        for (unsigned lineCount : lineCounts) {
+            for (unsigned i = 0; i < lineCount; i++) {
+                lines[i]->setClientPassword(clientPasswords[i]);
+                lines[i]->setServerPassword("parrot0");
+                lines[i]->setAudioOutputLine(LINE_ID_SINK);
+                lines[i]->open("52.8.247.112:1667", mux);
+                uint8_t lineKeepalive[voter::HEADER_SIZE + 160];
+                makeServerPacket(lineKeepalive, serverChallenge, 
+                    lines[i]->getExpectedDigest(), ulaw);
+                lineKeepalive[voter::OFFSET_PAYLOAD_TYPE + 1] = voter::PAYLOAD_NONE;
+                mux.dispatch(lineKeepalive, voter::HEADER_SIZE, 
+                    (const sockaddr&)serverAddr, clock.time());
+            }
+            uint8_t muxPacket[voter::HEADER_SIZE + 160];
+            unsigned muxPacketLen = makeServerPacket(muxPacket, serverChallenge,
+                lines[lineCount - 1]->getExpectedDigest(), ulaw);
+
+            char name[32];
+            snprintf(name, sizeof(name), "mux_dispatch_%u_lines", lineCount);
+            report(name, [&]() {
+                mux.dispatch(muxPacket, muxPacketLen, (const sockaddr&)serverAddr, 
+                    clock.time());
+            });
+            snprintf(name, sizeof(name), "mux_uplink_%u_lines", lineCount);
+            report(name, [&]() {
+                for (unsigned i = 0; i < lineCount; i++)
+                    lines[i]->consume(uplinkMsg);
+                simnet_advance(clock.time());
+            });
+
+            for (unsigned i = 0; i < lineCount; i++)
+                lines[i]->close();
+        }
+        mux.close();
+    }
+
+    // ----- Audio processing stages -------------------------------------------
+
+    AudioConditioner conditioner;
+    conditioner.setHighPass(true);
+    conditioner.setAgc(true);
+    report("conditioner_frame", [&]() {
+        int16_t frame[160];
+        memcpy(frame, pcm, sizeof(frame));
+        conditioner.process(frame, 160);
+        Bench::keep(frame);
+    });
+
+    ToneDetector tones;
+    tones.addCtcssTone(1000);
+    tones.setDtmfEnabled(true);
+    report("tone_detector_frame", [&]() {
+        ToneDetector::Event events[4];
+        unsigned n = tones.process(pcm, 160, events, 4);
+        Bench::keep(&n);
+    });
+
+    RssiEstimator rssi;
+    report("rssi_frame", [&]() {
+        rssi.update(pcm, 160);
+        uint8_t v = rssi.getRssi();
+        Bench::keep(&v);
+    });
+
+    AudioOutput audioOut(log, clock);
+    MessageWrapper downMsg(Message::Type::AUDIO, 0, 160, ulaw, 0, 0);
+    report("audio_output_frame", [&]() {
+        int16_t out[160];
+        audioOut.consume(downMsg);
+        audioOut.render(out, 160);
+        Bench::keep(out);
+    });
+
+    // ----- Generator and router ----------------------------------------------
+
+    SignalGenerator generator(log, clock, 25, router, LINE_ID_SINK);
+    report("signal_generator_tick", [&]() {
+        generator.audioRateTick(clock.time());
+    });
+
+    MessageWrapper routedMsg(Message::Type::AUDIO, 0, 160, ulaw, 0, 0);
+    routedMsg.setDest(LINE_ID_SINK, Message::UNKNOWN_CALL_ID);
+    report("router_dispatch", [&]() {
+        router.consume(routedMsg);
+    });
+
+    // Building and encoding one telemetry record (the send isn't included)
+    TelemetryExporter telemetry(log, clock);
+    telemetry.addLine(&client);
+    telemetry.addLine(&client);
+    report("telemetry_snapshot_encode", [&]() {
+        telemetry::Snapshot snap;
+        telemetry.snapshot(snap);
+        uint8_t rec[telemetry::RECORD_SIZE];
+        telemetry::encode(snap, rec, sizeof(rec));
+        Bench::keep(rec);
+    });
+
+    // ----- Event loop dispatch -------------------------------------------------
+
+    // The same tasks are run through an array of Runnable2s and through
+    // a StaticTaskGraph. A "pass" is what the event loop does every time
+    // around: run2() on everything. A "tick pass" is every tick hook.
+    SocketTask sock0, sock1;
+    BusyTask busy0, busy1, busy2;
+    TickTask tick0, tick1, tick2, tick3;
+    StatsTask stats0, stats1;
+    Runnable2* loopTasks[] = { &sock0, &busy0, &tick0, &tick1, &sock1, &busy1, 
+        &tick2, &tick3, &stats0, &busy2, &stats1 };
+    StaticTaskGraph loopGraph(sock0, busy0, tick0, tick1, sock1, busy1, 
+        tick2, tick3, stats0, busy2, stats1);
+    Runnable2* graphTasks[] = { &loopGraph };
+
+    report("loop_pass_virtual", [&]() {
+        bool b = virtualPass(loopTasks, std::size(loopTasks));
+        Bench::keep(&b);
+    });
+    report("loop_pass_static", [&]() {
+        bool b = virtualPass(graphTasks, std::size(graphTasks));
+        Bench::keep(&b);
+    });
+    report("loop_tick_pass_virtual", [&]() {
+        virtualTickPass(loopTasks, std::size(loopTasks), 20);
+    });
+    report("loop_tick_pass_static", [&]() {
+        virtualTickPass(graphTasks, std::size(graphTasks), 20);
+    });
+
+    // The firmware's own task set, less the Pico-only tasks (CYW43, the
+    // timer and the PWM driver), with the two lines on a mux and behind
+    // the aligner as in main.cpp. The socket is open but idle.
+    simnet_reset(1);
+    simnet_set_link(0, 0, 0);
+    VoterMux realMux(log, clock);
+    realMux.open(AF_INET);
+    VoterClient realLineA(log, clock, LINE_ID_VOTER, router);
+    VoterClient realLineB(log, clock, LINE_ID_VOTER + 2, router);
+    realLineA.setClientPassword("client0");
+    realLineA.setServerPassword("parrot0");
+    realLineA.open("52.8.247.112:1667", realMux);
+    realLineB.setClientPassword("client1");
+    realLineB.setServerPassword("parrot0");
+    realLineB.open("52.8.247.112:1667", realMux);
+    AudioOutput realAudioOut(log, clock);
+    HeapGuard realHeapGuard(log);
+    DeferredLog realDlog(log, clock);
+    TelemetryExporter realTelemetry(log, clock);
+    realTelemetry.addLine(&realLineA);
+    realTelemetry.addLine(&realLineB);
+
+    Runnable2* realLines[] = { &realLineA, &realLineB };
+    TickAligner realAligner(log, clock, realLines, std::size(realLines));
+    Runnable2* realTasks[] = { &realMux, &realAligner, &realAudioOut, 
+        &realHeapGuard, &realDlog, &realTelemetry };
+
+    StaticTaskGraph realLineGraph(realLineA, realLineB);
+    Runnable2* realLineGraphs[] = { &realLineGraph };
+    TickAligner realGraphAligner(log, clock, realLineGraphs, std::size(realLineGraphs));
+    StaticTaskGraph realGraph(realMux, realGraphAligner, realAudioOut, 
+        realHeapGuard, realDlog, realTelemetry);
+    Runnable2* realGraphTasks[] = { &realGraph };
+
+    report("loop_pass_real_virtual", [&]() {
+        bool b = virtualPass(realTasks, std::size(realTasks));
+        Bench::keep(&b);
+    });
+    report("loop_pass_real_static", [&]() {
+        bool b = virtualPass(realGraphTasks, std::size(realGraphTasks));
+        Bench::keep(&b);
+    });
+    // Only the audio tick (every 20ms) here. The one and ten second 
+    // ticks of the real tasks write to the log.
+    report("loop_audio_tick_real_virtual", [&]() {
+        virtualAudioTickPass(realTasks, std::size(realTasks), 20);
+    });
+    report("loop_audio_tick_real_static", [&]() {
+        virtualAudioTickPass(realGraphTasks, std::size(realGraphTasks), 20);
+    });
+    realLineA.close();
+    realLineB.close();
+    realMux.close();
+
+    // ----- Sockets -----------------------------------------------------------
+
+    simnet_reset(1);
+    simnet_set_link(0, 0, 0);
+    int txFd = socket(AF_INET, SOCK_DGRAM, 0);
+    int rxFd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in rxAddr;
+    memset(&rxAddr, 0, sizeof(rxAddr));
+    rxAddr.sin_family = AF_INET;
+    rxAddr.sin_port = htons(1667);
+    inet_pton(AF_INET, "10.0.0.1", &rxAddr.sin_addr);
+    bind(rxFd, (const sockaddr*)&rxAddr, sizeof(rxAddr));
+
+    // The common case in run2(): nothing waiting
+    report("microip_recvfrom_empty", [&]() {
+        uint8_t buf[512];
+        sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        int rc = recvfrom(rxFd, buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+        Bench::keep(&rc);
+    });
+
+    report("microip_sendto_recvfrom", [&]() {
+        sendto(txFd, clientPacket, clientPacketLen, 0, (const sockaddr*)&rxAddr, 
+            sizeof(rxAddr));
+        simnet_advance(0);
+        uint8_t buf[512];
+        sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        int rc = recvfrom(rxFd, buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+        Bench::keep(buf);
+        Bench::keep(&rc);
+    });
+
+    close(txFd);
+    close(rxFd);
+
+    // ----- Codec quality --------------------------------------------------------
+
+    printf("\n],\"quality\":[\n");
+    const char* levels[] = { "full", "minus20db" };
+    for (unsigned l = 0; l < 2; l++) {
+        double ulawSnr, adpcmSnr;
+        codecSnr(l == 0 ? 1.0 : 0.1, ulawSnr, adpcmSnr);
+        printf("{\"name\":\"ulaw_snr_db\",\"level\":\"%s\",\"value\":%.1f},\n", 
+            levels[l], ulawSnr);
+        printf("{\"name\":\"adpcm_snr_db\",\"level\":\"%s\",\"value\":%.1f}%s\n", 
+            levels[l], adpcmSnr, l == 1 ? "" : ",");
+    }
+
+    printf("]}\n");
+    return 0;
+}
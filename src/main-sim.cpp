@@ -0,0 +1,446 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * voter-sim: runs the voter (two receiver lines on a shared socket, 
+ * the tone generators and the audio output) against a simulated VOTER 
+ * server on an in-process network, all in virtual time. A day of 
+ * operation takes a few seconds and the same seed and script always 
+ * produce the same run (compare the network fingerprint).
+ *
+ * Example:
+ *
+ *   voter-sim --seed 7 --hours 24 --delay 40 --jitter 30 --loss 2000 \
+ *     --outage 3600:20 --restart 7200
+ *
+ * Tick alignment (the result should be "locked" with a phase error of 0):
+ *
+ *   voter-sim --seconds 60 --downlink --align --server-offset 7 --jitter 10
+ *
+ * Telemetry (records go to a collector on the simulated network and are
+ * decoded there):
+ *
+ *   voter-sim --hours 1 --telemetry 60 --loss 5000
+ */
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <iterator>
+
+#include "kc1fsz-tools/Log.h"
+#include "kc1fsz-tools/NetUtils.h"
+
+// amp-core
+#include "SimpleRouter.h"
+
+#include "simnet.h"
+#include "SimClock.h"
+#include "SimEventLoop.h"
+#include "SimVoterServer.h"
+#include "VoterClient.h"
+#include "VoterMux.h"
+#include "SignalGenerator.h"
+#include "AudioOutput.h"
+#include "WavAudioDriver.h"
+#include "DeferredLog.h"
+#include "HeapGuard.h"
+#include "TickAligner.h"
+#include "TelemetryExporter.h"
+
+// Same line layout as the firmware
+#define LINE_ID_VOTER (24)
+#define LINE_ID_GENERATOR (25)
+#define LINE_ID_VOTER_B (26)
+#define LINE_ID_GENERATOR_B (27)
+#define LINE_ID_AUDIO_OUT (28)
+
+#define SERVER_ADDR "52.8.247.112:1667"
+#define COLLECTOR_ADDR "10.0.0.9:5199"
+
+using namespace std;
+using namespace kc1fsz;
+
+struct ScriptEvent {
+    enum Kind { LINK_DOWN, LINK_UP, SERVER_RESTART };
+    uint32_t atMs;
+    Kind kind;
+};
+
+static const unsigned MAX_SCRIPT_EVENTS = 32;
+
+/**
+ * Stands in for voter-telemetry: decodes whatever arrives on the
+ * collector address and keeps the latest record.
+ */
+class TelemetrySink : public Runnable2 {
+public:
+
+    int open() {
+        sockaddr_storage a;
+        if (parseIPAddrAndPort(COLLECTOR_ADDR, a) != 0)
+            return -1;
+        _fd = socket(AF_INET, SOCK_DGRAM, 0);
+        return bind(_fd, (const sockaddr*)&a, sizeof(sockaddr_in));
+    }
+
+    virtual bool run2() {
+        if (!_fd)
+            return false;
+        uint8_t buf[512];
+        sockaddr_in peer;
+        socklen_t peerLen = sizeof(peer);
+        int rc = recvfrom(_fd, buf, sizeof(buf), 0, (sockaddr*)&peer, &peerLen);
+        if (rc <= 0)
+            return false;
+        if (telemetry::decode(buf, rc, last) == 0)
+            received++;
+        else
+            bad++;
+        return true;
+    }
+
+    telemetry::Snapshot last;
+    uint32_t received = 0;
+    uint32_t bad = 0;
+
+private:
+
+    int _fd = 0;
+};
+
+static void usage() {
+    fprintf(stderr, 
+        "usage: voter-sim [options]\n"
+        "  --seed N            Seed for every random choice (default 1)\n"
+        "  --hours H           Virtual run time (default 1)\n"
+        "  --seconds S         Virtual run time\n"
+        "  --delay MS          One-way network delay (default 30)\n"
+        "  --jitter MS         Extra random delay 0..MS (default 0)\n"
+        "  --loss PPM          Random packet loss (default 0)\n"
+        "  --outage AT:DUR     Link down at AT seconds for DUR seconds\n"
+        "  --restart AT        Restart the server at AT seconds\n"
+        "  --downlink          Server sends audio\n"
+        "  --codec C           Uplink codec: ulaw, adpcm or auto (default ulaw)\n"
+        "  --downlink-adpcm    Server sends its audio as ADPCM\n"
+        "  --wav PATH          Write the downlink audio to a WAV file\n"
+        "  --trace             Network tracing on the clients\n"
+        "  --align             Align the client audio ticks to the server\n"
+        "  --server-offset MS  Server clock ahead of the local clock by MS\n"
+        "  --telemetry SEC     Send telemetry every SEC seconds\n");
+}
+
+int main(int argc, const char** argv) {
+
+    uint32_t seed = 1;
+    double runSec = 3600;
+    uint32_t delayMs = 30, jitterMs = 0, lossPpm = 0;
+    bool downlink = false, trace = false, align = false, downlinkAdpcm = false;
+    VoterClient::UplinkCodec codec = VoterClient::CODEC_ULAW;
+    int32_t serverOffsetMs = 0;
+    unsigned telemetrySec = 0;
+    const char* wavPath = 0;
+    ScriptEvent script[MAX_SCRIPT_EVENTS];
+    unsigned scriptLen = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : 0;
+        if (strcmp(a, "--downlink") == 0)
+            downlink = true;
+        else if (strcmp(a, "--downlink-adpcm") == 0)
+            downlinkAdpcm = true;
+        else if (strcmp(a, "--trace") == 0)
+            trace = true;
+        else if (strcmp(a, "--align") == 0)
+            align = true;
+        else if (!v) {
+            usage();
+            return 1;
+        }
+        else if (strcmp(a, "--seed") == 0)
+            seed = strtoul(v, 0, 10), i++;
+        else if (strcmp(a, "--hours") == 0)
+            runSec = atof(v) * 3600.0, i++;
+        else if (strcmp(a, "--seconds") == 0)
+            runSec = atof(v), i++;
+        else if (strcmp(a, "--delay") == 0)
+            delayMs = strtoul(v, 0, 10), i++;
+        else if (strcmp(a, "--jitter") == 0)
+            jitterMs = strtoul(v, 0, 10), i++;
+        else if (strcmp(a, "--loss") == 0)
+            lossPpm = strtoul(v, 0, 10), i++;
+        else if (strcmp(a, "--codec") == 0) {
+            if (strcmp(v, "ulaw") == 0)
+                codec = VoterClient::CODEC_ULAW;
+            else if (strcmp(v, "adpcm") == 0)
+                codec = VoterClient::CODEC_ADPCM;
+            else if (strcmp(v, "auto") == 0)
+                codec = VoterClient::CODEC_AUTO;
+            else {
+                usage();
+                return 1;
+            }
+            i++;
+        }
+        else if (strcmp(a, "--server-offset") == 0)
+            serverOffsetMs = strtol(v, 0, 10), i++;
+        else if (strcmp(a, "--telemetry") == 0)
+            telemetrySec = strtoul(v, 0, 10), i++;
+        else if (strcmp(a, "--wav") == 0)
+            wavPath = v, i++;
+        else if (strcmp(a, "--outage") == 0 && scriptLen + 2 <= MAX_SCRIPT_EVENTS) {
+            unsigned at = 0, dur = 0;
+            if (sscanf(v, "%u:%u", &at, &dur) != 2) {
+                usage();
+                return 1;
+            }
+            script[scriptLen++] = { at * 1000, ScriptEvent::LINK_DOWN };
+            script[scriptLen++] = { (at + dur) * 1000, ScriptEvent::LINK_UP };
+            i++;
+        }
+        else if (strcmp(a, "--restart") == 0 && scriptLen < MAX_SCRIPT_EVENTS) {
+            script[scriptLen++] = { (uint32_t)strtoul(v, 0, 10) * 1000, 
+                ScriptEvent::SERVER_RESTART };
+            i++;
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+    // Ties are broken by the order given on the command line
+    stable_sort(script, script + scriptLen, 
+        [](const ScriptEvent& a, const ScriptEvent& b) { return a.atMs < b.atMs; });
+
+    // Everything random has to come from the seed (the challenges 
+    // picked by the clients included)
+    srand(seed);
+    simnet_reset(seed);
+    simnet_set_link(delayMs, jitterMs, lossPpm);
+
+    SimClock clock;
+    Log log;
+    DeferredLog dlog(log, clock);
+    SimpleRouter router;
+
+    SimVoterServer server(log, clock);
+    server.setSeed(seed);
+    server.setServerPassword("parrot0");
+    server.addClientPassword("client0");
+    server.addClientPassword("client1");
+    server.setDownlinkAudio(downlink);
+    server.setClockOffset(serverOffsetMs);
+    server.setDownlinkAdpcm(downlinkAdpcm);
+    if (server.open(SERVER_ADDR) != 0) {
+        log.error("Failed to open server");
+        return 1;
+    }
+
+    VoterMux mux(log, clock);
+    mux.setDeferredLog(&dlog);
+    if (mux.open(AF_INET) != 0) {
+        log.error("Failed to open shared socket");
+        return 1;
+    }
+
+    VoterClient client24(log, clock, LINE_ID_VOTER, router);
+    router.addRoute(&client24, LINE_ID_VOTER);
+    client24.setDeferredLog(&dlog);
+    client24.setTrace(trace);
+    client24.setUplinkCodec(codec);
+    client24.setClientPassword("client0");
+    client24.setServerPassword("parrot0");
+    if (client24.open(SERVER_ADDR, mux) != 0) {
+        log.error("Failed to open connection");
+        return 1;
+    }
+
+    VoterClient client26(log, clock, LINE_ID_VOTER_B, router);
+    router.addRoute(&client26, LINE_ID_VOTER_B);
+    client26.setDeferredLog(&dlog);
+    client26.setTrace(trace);
+    client26.setUplinkCodec(codec);
+    client26.setClientPassword("client1");
+    client26.setServerPassword("parrot0");
+    if (client26.open(SERVER_ADDR, mux) != 0) {
+        log.error("Failed to open connection");
+        return 1;
+    }
+
+    SignalGenerator generator25(log, clock, LINE_ID_GENERATOR, router, LINE_ID_VOTER);
+    router.addRoute(&generator25, LINE_ID_GENERATOR);
+    SignalGenerator generator27(log, clock, LINE_ID_GENERATOR_B, router, LINE_ID_VOTER_B, 
+        600.0f);
+    router.addRoute(&generator27, LINE_ID_GENERATOR_B);
+
+    AudioOutput audioOut(log, clock);
+    router.addRoute(&audioOut, LINE_ID_AUDIO_OUT);
+    client24.setAudioOutputLine(LINE_ID_AUDIO_OUT);
+    WavAudioDriver wavOut(log, audioOut);
+    if (wavPath && wavOut.open(wavPath) != 0)
+        return 1;
+
+    // When aligning, the receive lines get their audio tick from the
+    // TickAligner instead of the loop
+    Runnable2* alignedTasks[] = { &client24, &client26, &generator25, &generator27 };
+    TickAligner aligner(log, clock, alignedTasks, std::size(alignedTasks));
+    aligner.setTrace(trace);
+    client24.setServerTimeObserver([&aligner](uint32_t serverMs, uint32_t rxMs, 
+        uint32_t rttMs) {
+        aligner.observeServerTime(serverMs, rxMs, rttMs);
+    });
+
+    TelemetryExporter telemetry(log, clock);
+    TelemetrySink collector;
+    if (telemetrySec) {
+        telemetry.setIntervalSec(telemetrySec);
+        telemetry.setNodeId("sim-voter");
+        if (telemetry.addLine(&client24) != 0 || telemetry.addLine(&client26) != 0) {
+            log.error("Failed to add telemetry line");
+            return 1;
+        }
+        if (align)
+            telemetry.setAligner(&aligner);
+        telemetry.setDeferredLog(&dlog);
+        telemetry.setNetStatsSource([](telemetry::NetCounters& n) {
+            simnet_stats ns;
+            simnet_get_stats(&ns);
+            n.rxPackets = ns.delivered;
+            n.rxOverflows = ns.rxOverflow;
+            n.txPackets = ns.sent;
+            n.txErrors = ns.inFlightFull;
+        });
+        if (collector.open() != 0 || 
+            telemetry.open(COLLECTOR_ADDR) != 0) {
+            log.error("Failed to open telemetry");
+            return 1;
+        }
+    }
+
+    // Watches for heap use once the loop is running, as on the Pico
+    HeapGuard heapGuard(log);
+
+    // The server goes first so that its packets are in flight before
+    // the clients look for them
+    Runnable2* tasks[] = { &server, &mux, &client24, &client26, 
+        &generator25, &generator27, &audioOut, &wavOut, &dlog, &telemetry, &collector,
+        &heapGuard };
+    Runnable2* tasksAligned[] = { &server, &mux, &aligner, &audioOut, &wavOut, &dlog,
+        &telemetry, &collector, &heapGuard };
+    SimEventLoop loop(log, clock, align ? tasksAligned : tasks, 
+        align ? std::size(tasksAligned) : std::size(tasks));
+    // The aligner keeps its own schedule so it needs to see every ms
+    if (align)
+        loop.setMaxStepMs(1);
+
+    const uint32_t endMs = (uint32_t)(runSec * 1000.0);
+    auto wallStart = chrono::steady_clock::now();
+    heapGuard.arm();
+
+    for (unsigned i = 0; i <= scriptLen; i++) {
+        const uint32_t atMs = (i < scriptLen) ? std::min(script[i].atMs, endMs) : endMs;
+        loop.runUntil(atMs);
+        if (i == scriptLen || atMs == endMs)
+            break;
+        if (script[i].kind == ScriptEvent::LINK_DOWN) {
+            log.info("Script: link down");
+            simnet_set_down(1);
+        } else if (script[i].kind == ScriptEvent::LINK_UP) {
+            log.info("Script: link up");
+            simnet_set_down(0);
+        } else {
+            server.restart();
+        }
+    }
+
+    // Get the rest of the deferred messages out
+    while (dlog.drain(DeferredLog::RING_SIZE));
+    wavOut.close();
+
+    const double wallSec = chrono::duration<double>(
+        chrono::steady_clock::now() - wallStart).count();
+
+    simnet_stats ns;
+    simnet_get_stats(&ns);
+    const SimEventLoop::Stats& ls = loop.getStats();
+
+    printf("Virtual time         %.0f s\n", endMs / 1000.0);
+    printf("Wall time            %.2f s (x%.0f)\n", wallSec, 
+        wallSec > 0 ? (endMs / 1000.0) / wallSec : 0.0);
+    printf("Loop                 events %u, ticks %u, run2 %u, busy %u\n",
+        ls.events, ls.audioTicks, ls.run2Calls, ls.busyLimitHits);
+    printf("Network              sent %u, delivered %u, lost %u, no route %u, "
+        "overflow %u, full %u\n", ns.sent, ns.delivered, ns.lost, ns.noRoute, 
+        ns.rxOverflow, ns.inFlightFull);
+    printf("Network fingerprint  %08x\n", ns.fingerprint);
+    for (unsigned i = 0; i < SimVoterServer::MAX_CLIENTS; i++) {
+        const SimVoterServer::Session& s = server.getSession(i);
+        if (!s.active)
+            continue;
+        printf("Server session %u     auth %u, uplink frames %u (ADPCM %u), "
+            "stamp lag %d..%d ms\n", i, s.authCount, s.uplinkFrames, 
+            s.uplinkAdpcmFrames, s.stampLagMinMs, s.stampLagMaxMs);
+    }
+    printf("Server               bad digest %u\n", server.getBadDigestCount());
+    VoterClient* clients[] = { &client24, &client26 };
+    for (VoterClient* c : clients) {
+        const LatencyEstimator& rtt = c->getRttStats();
+        const OutboundScheduler::Stats& sa = 
+            c->getScheduler().getStats(OutboundScheduler::AUDIO);
+        const OutboundScheduler::Stats& sc = 
+            c->getScheduler().getStats(OutboundScheduler::CONTROL);
+        printf("Client               RTT n %u mean %d p95 %d ms, sent %u/%u, "
+            "dropped %u/%u, auth rejects %u\n", rtt.getCount(), rtt.getMean(), 
+            rtt.getP95(), sa.sent, sc.sent, sa.dropped, sc.dropped, 
+            c->getAuthRejectCount());
+    }
+    printf("Audio out            frames %u, underruns %u, overruns %u\n",
+        audioOut.getStats().framesIn, audioOut.getStats().underruns, 
+        audioOut.getStats().overruns);
+    printf("Deferred log         overflow %u\n", dlog.getOverflowCount());
+    if (align) {
+        const TickAligner::Stats& as = aligner.getStats();
+        printf("Tick alignment       phase error %d ms, %s, ticks %u, nudges %u, "
+            "late %u, resyncs %u\n", aligner.getPhaseErrorMs(), 
+            aligner.isLocked() ? "locked" : "unlocked", as.ticks, as.nudges,
+            as.lateTicks, as.resyncs);
+    }
+
+    if (telemetrySec) {
+        const telemetry::Snapshot& t = collector.last;
+        printf("Telemetry            sent %u (forced %u), errors %u, received %u, bad %u, "
+            "last seq %u at %u s from %s\n", telemetry.getSentCount(), 
+            telemetry.getForcedSendCount(), telemetry.getSendErrorCount(), 
+            collector.received, collector.bad, 
+            t.sequence, t.uptimeSec, t.nodeId);
+        printf("Telemetry loop       passes %u, ticks %u, late %u/%u/%u/%u, max gap %u ms\n",
+            t.loopPasses, t.audioTicks, t.tickHist[1], t.tickHist[2], t.tickHist[3], 
+            t.tickHist[4], t.maxTickGapMs);
+        for (unsigned i = 0; i < t.lineCount; i++)
+            printf("Telemetry line %u     rtt %u/%u/%u ms (n %u), audio sent %u, "
+                "dropped %u\n", t.lines[i].lineId, t.lines[i].rttMinMs, 
+                t.lines[i].rttMeanMs, t.lines[i].rttP95Ms, t.lines[i].rttCount, 
+                t.lines[i].audioSent, t.lines[i].audioDropped);
+    }
+
+    return 0;
+}
@@ -0,0 +1,234 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/*
+ * voter-telemetry: the collector for the records sent by the
+ * TelemetryExporter. Every record is appended to a CSV file as one row
+ * (receive time, node id, sender address and every field, totals as 
+ * sent), which is the time series. A one-line summary of each record, 
+ * with the changes since the voter's previous record, goes to stderr.
+ *
+ * Voters are told apart by the node id in the record, so a voter that
+ * moves or restarts behind NAT is still the same voter. The sender's
+ * address is only used for voters that don't send an id.
+ *
+ *   voter-telemetry --port 5199 --out telemetry.csv
+ */
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "TelemetryRecord.h"
+
+using namespace kc1fsz;
+
+// Voters tracked for the summary
+static const unsigned MAX_VOTERS = 64;
+
+// Node id, or addr:port for a voter without one
+static const unsigned KEY_SIZE = 32;
+
+struct Voter {
+    char key[KEY_SIZE] = { 0 };
+    bool valid = false;
+    telemetry::Snapshot last;
+};
+
+static void usage() {
+    fprintf(stderr,
+        "usage: voter-telemetry [options]\n"
+        "  --port N     UDP port to listen on (default 5199)\n"
+        "  --out PATH   Append records to this CSV file (default stdout)\n"
+        "  --quiet      No summary on stderr\n");
+}
+
+static void writeHeader(FILE* f) {
+    fprintf(f, "time,node,addr,seq,uptime,interval,flags,phase_err_ms,max_tick_gap_ms,"
+        "loop_passes,audio_ticks");
+    for (unsigned i = 0; i < telemetry::TICK_HIST_BUCKETS; i++)
+        fprintf(f, ",tick_late_%u", i);
+    fprintf(f, ",log_overflows,net_rx,net_rx_overflows,net_tx,net_tx_errors");
+    for (unsigned n = 0; n < telemetry::MAX_LINES; n++) {
+        fprintf(f, ",l%u_id,l%u_flags,l%u_rssi,l%u_rtt_min,l%u_rtt_mean,l%u_rtt_p95,"
+            "l%u_rtt_max,l%u_rtt_n,l%u_auth_rejects,l%u_audio_sent,l%u_audio_dropped,"
+            "l%u_audio_busy,l%u_audio_max_queued_ms,l%u_control_sent,l%u_control_dropped",
+            n, n, n, n, n, n, n, n, n, n, n, n, n, n, n);
+        for (unsigned i = 0; i < telemetry::RTT_HIST_BUCKETS; i++)
+            fprintf(f, ",l%u_rtt_hist_%u", n, i);
+    }
+    fprintf(f, "\n");
+}
+
+static void writeRow(FILE* f, time_t t, const char* addr, const telemetry::Snapshot& s) {
+    fprintf(f, "%ld,%s,%s,%u,%u,%u,%u,%d,%u,%u,%u", (long)t, s.nodeId, addr, s.sequence,
+        s.uptimeSec, s.intervalSec, s.flags, s.phaseErrorMs, s.maxTickGapMs,
+        s.loopPasses, s.audioTicks);
+    for (unsigned i = 0; i < telemetry::TICK_HIST_BUCKETS; i++)
+        fprintf(f, ",%u", s.tickHist[i]);
+    fprintf(f, ",%u,%u,%u,%u,%u", s.logOverflows, s.net.rxPackets,
+        s.net.rxOverflows, s.net.txPackets, s.net.txErrors);
+    for (unsigned n = 0; n < telemetry::MAX_LINES; n++) {
+        const telemetry::LineStats& l = s.lines[n];
+        fprintf(f, ",%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u",
+            l.lineId, l.flags, l.rssi, l.rttMinMs, l.rttMeanMs, l.rttP95Ms,
+            l.rttMaxMs, l.rttCount, l.authRejects, l.audioSent, l.audioDropped,
+            l.audioBusy, l.audioMaxQueuedMs, l.controlSent, l.controlDropped);
+        for (unsigned i = 0; i < telemetry::RTT_HIST_BUCKETS; i++)
+            fprintf(f, ",%u", l.rttHist[i]);
+    }
+    fprintf(f, "\n");
+    fflush(f);
+}
+
+static void writeSummary(const char* key, const telemetry::Snapshot& s,
+    const Voter& v) {
+
+    // Totals restart when the voter does
+    const bool prev = v.valid && s.uptimeSec >= v.last.uptimeSec;
+    const telemetry::Snapshot& p = prev ? v.last : telemetry::Snapshot();
+
+    uint32_t late = 0;
+    for (unsigned i = 1; i < telemetry::TICK_HIST_BUCKETS; i++)
+        late += s.tickHist[i] - p.tickHist[i];
+
+    fprintf(stderr, "%s seq %u up %us%s: passes %u, late ticks %u, rx %u, "
+        "rx overflows %u, tx errors %u", key, s.sequence, s.uptimeSec,
+        !v.valid ? "" : !prev ? " (restarted)" :
+            s.sequence != v.last.sequence + 1 ? " (gap)" : "",
+        s.loopPasses - p.loopPasses,
+        late,
+        s.net.rxPackets - p.net.rxPackets, s.net.rxOverflows - p.net.rxOverflows,
+        s.net.txErrors - p.net.txErrors);
+    if (s.flags & telemetry::FLAG_ALIGNED)
+        fprintf(stderr, ", phase %d ms %s", s.phaseErrorMs,
+            (s.flags & telemetry::FLAG_LOCKED) ? "locked" : "unlocked");
+    for (unsigned n = 0; n < s.lineCount; n++) {
+        const telemetry::LineStats& l = s.lines[n];
+        const telemetry::LineStats& pl = p.lines[n];
+        fprintf(stderr, " | line %u rtt %u/%u ms, sent %u, dropped %u", l.lineId,
+            l.rttMeanMs, l.rttP95Ms, l.audioSent - pl.audioSent,
+            l.audioDropped - pl.audioDropped);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, const char** argv) {
+
+    unsigned port = 5199;
+    const char* outPath = 0;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : 0;
+        if (strcmp(a, "--quiet") == 0)
+            quiet = true;
+        else if (strcmp(a, "--port") == 0 && v)
+            port = strtoul(v, 0, 10), i++;
+        else if (strcmp(a, "--out") == 0 && v)
+            outPath = v, i++;
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    FILE* out = stdout;
+    if (outPath) {
+        out = fopen(outPath, "a");
+        if (!out) {
+            fprintf(stderr, "Unable to open %s\n", outPath);
+            return 1;
+        }
+        // Only a new file gets the header
+        if (ftell(out) == 0)
+            writeHeader(out);
+    } else
+        writeHeader(out);
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (const sockaddr*)&local, sizeof(local)) != 0) {
+        perror("bind");
+        return 1;
+    }
+    if (!quiet)
+        fprintf(stderr, "Listening on UDP port %u\n", port);
+
+    static Voter voters[MAX_VOTERS];
+    uint32_t badCount = 0;
+
+    while (true) {
+
+        uint8_t buf[2048];
+        sockaddr_in peer;
+        socklen_t peerLen = sizeof(peer);
+        int rc = recvfrom(fd, buf, sizeof(buf), 0, (sockaddr*)&peer, &peerLen);
+        if (rc < 0) {
+            perror("recvfrom");
+            return 1;
+        }
+
+        telemetry::Snapshot s;
+        if (telemetry::decode(buf, rc, s) != 0) {
+            if (!quiet)
+                fprintf(stderr, "Ignored a %d byte datagram (%u so far)\n", rc,
+                    ++badCount);
+            continue;
+        }
+
+        char addr[32];
+        char ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &peer.sin_addr, ip, sizeof(ip));
+        snprintf(addr, sizeof(addr), "%s:%u", ip, ntohs(peer.sin_port));
+        writeRow(out, time(0), addr, s);
+
+        const char* key = s.nodeId[0] ? s.nodeId : addr;
+
+        // Find the voter, or take a free slot (the first one is reused
+        // when the table is full)
+        Voter* v = 0;
+        for (unsigned i = 0; i < MAX_VOTERS && !v; i++)
+            if (voters[i].valid && strcmp(voters[i].key, key) == 0)
+                v = &voters[i];
+        for (unsigned i = 0; i < MAX_VOTERS && !v; i++)
+            if (!voters[i].valid)
+                v = &voters[i];
+        if (!v) {
+            v = &voters[0];
+            v->valid = false;
+        }
+        if (!quiet)
+            writeSummary(key, s, *v);
+        snprintf(v->key, sizeof(v->key), "%s", key);
+        v->last = s;
+        v->valid = true;
+    }
+}
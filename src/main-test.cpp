@@ -0,0 +1,1006 @@
+/**
+ * Copyright (C) 2026, Bruce MacKinnon KC1FSZ
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/*
+ * voter-test: host unit tests for the parts of the voter that can be
+ * checked without a network or a server. Every failed check is printed
+ * and the exit status is non-zero if there were any, so this runs under
+ * ctest:
+ *
+ *   voter-test
+ *   voter-test --filter scheduler
+ */
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+#include "kc1fsz-tools/Log.h"
+
+#include "Runnable2.h"
+
+#include "SimClock.h"
+#include "OutboundScheduler.h"
+#include "AudioConditioner.h"
+#include "ToneDetector.h"
+#include "TickAligner.h"
+#include "VoterProto.h"
+#include "VoterAuth.h"
+#include "TelemetryRecord.h"
+#include "RttProbe.h"
+#include "Transcoder_IMA_ADPCM.h"
+
+using namespace std;
+using namespace kc1fsz;
+
+namespace {
+
+unsigned failures = 0;
+
+#define CHECK(cond) check((cond), #cond, __FILE__, __LINE__)
+
+void check(bool ok, const char* what, const char* file, int line) {
+    if (!ok) {
+        printf("  FAILED %s:%d: %s\n", file, line, what);
+        failures++;
+    }
+}
+
+sockaddr_in testAddr() {
+    sockaddr_in a;
+    memset(&a, 0, sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_port = htons(1667);
+    a.sin_addr.s_addr = htonl(0x7f000001);
+    return a;
+}
+
+/**
+ * A sine at 8 kHz, continuing from the phase left by the last call.
+ */
+struct Tone {
+    float hz;
+    float amplitude;
+    float phase = 0;
+    void fill(int16_t* b, unsigned len) {
+        for (unsigned i = 0; i < len; i++) {
+            b[i] = (int16_t)std::lround(amplitude * std::sin(phase));
+            phase += 2.0f * 3.1415926f * hz / 8000.0f;
+            if (phase > 2.0f * 3.1415926f)
+                phase -= 2.0f * 3.1415926f;
+        }
+    }
+};
+
+float rms(const int16_t* b, unsigned len) {
+    double sum = 0;
+    for (unsigned i = 0; i < len; i++)
+        sum += (double)b[i] * b[i];
+    return std::sqrt(sum / len);
+}
+
+int16_t peak(const int16_t* b, unsigned len) {
+    int16_t p = 0;
+    for (unsigned i = 0; i < len; i++)
+        p = std::max(p, (int16_t)std::abs(b[i]));
+    return p;
+}
+
+// ----- OutboundScheduler ---------------------------------------------------
+
+/**
+ * Records what goes out (the first byte of each packet) and answers with
+ * whatever the test sets.
+ */
+struct TestSender {
+    int rc = OutboundScheduler::SEND_OK;
+    vector<uint8_t> sent;
+    unsigned calls = 0;
+
+    void attach(OutboundScheduler& s) {
+        s.setSender([this](const uint8_t* b, unsigned, const sockaddr&) {
+            calls++;
+            if (rc == OutboundScheduler::SEND_OK)
+                sent.push_back(b[0]);
+            return rc;
+        });
+    }
+};
+
+void submit(OutboundScheduler& s, OutboundScheduler::Class c, uint8_t tag,
+    uint32_t nowMs = 0) {
+    uint8_t packet[24] = { tag };
+    sockaddr_in a = testAddr();
+    s.submit(c, packet, sizeof(packet), (const sockaddr&)a, nowMs);
+}
+
+void testSchedulerAudioImmediate() {
+    OutboundScheduler s;
+    TestSender t;
+    t.attach(s);
+    submit(s, OutboundScheduler::AUDIO, 1);
+    CHECK(t.sent.size() == 1);
+    CHECK(s.getDepth(OutboundScheduler::AUDIO) == 0);
+    CHECK(s.getStats(OutboundScheduler::AUDIO).sent == 1);
+}
+
+void testSchedulerControlTokens() {
+    OutboundScheduler s;
+    TestSender t;
+    t.attach(s);
+
+    // Control always waits for the tick
+    submit(s, OutboundScheduler::CONTROL, 1);
+    CHECK(t.sent.empty());
+    CHECK(s.getDepth(OutboundScheduler::CONTROL) == 1);
+    s.drain(0);
+    CHECK(t.sent.size() == 1);
+
+    // The bucket refills one token per tick up to the burst, so after an
+    // idle tick a full queue goes out in one go...
+    s.drain(20);
+    for (unsigned i = 0; i < OutboundScheduler::CONTROL_BURST; i++)
+        submit(s, OutboundScheduler::CONTROL, 10 + i);
+    t.sent.clear();
+    s.drain(40);
+    CHECK(t.sent.size() == OutboundScheduler::CONTROL_BURST);
+
+    // ... and then it's one per tick
+    for (unsigned i = 0; i < 3; i++)
+        submit(s, OutboundScheduler::CONTROL, 20 + i);
+    t.sent.clear();
+    s.drain(60);
+    CHECK(t.sent.size() == OutboundScheduler::CONTROL_TOKENS_PER_TICK);
+    s.drain(80);
+    s.drain(100);
+    CHECK(t.sent.size() == 3);
+    CHECK(s.getDepth(OutboundScheduler::CONTROL) == 0);
+    // In order
+    CHECK(t.sent.size() == 3 && t.sent[0] == 20 && t.sent[1] == 21 &&
+        t.sent[2] == 22);
+
+    // A full control queue drops the newest
+    for (unsigned i = 0; i < OutboundScheduler::QUEUE_DEPTH + 1; i++)
+        submit(s, OutboundScheduler::CONTROL, 30 + i);
+    CHECK(s.getStats(OutboundScheduler::CONTROL).dropped == 1);
+    t.sent.clear();
+    for (unsigned i = 0; i < OutboundScheduler::QUEUE_DEPTH; i++)
+        s.drain(120 + i * 20);
+    CHECK(t.sent.size() == OutboundScheduler::QUEUE_DEPTH);
+    CHECK(!t.sent.empty() && t.sent.back() == 30 + OutboundScheduler::QUEUE_DEPTH - 1);
+}
+
+void testSchedulerPriority() {
+    OutboundScheduler s;
+    TestSender t;
+    t.attach(s);
+
+    // The network pushes back so both classes wait
+    t.rc = OutboundScheduler::SEND_BUSY;
+    submit(s, OutboundScheduler::CONTROL, 1);
+    submit(s, OutboundScheduler::AUDIO, 2);
+    submit(s, OutboundScheduler::AUDIO, 3);
+    CHECK(s.getDepth(OutboundScheduler::AUDIO) == 2);
+    CHECK(s.getStats(OutboundScheduler::AUDIO).busy == 1);
+
+    // Nothing moves while the network is still busy, and control
+    // doesn't get around the stuck audio
+    t.calls = 0;
+    s.drain(20);
+    CHECK(t.calls == 1);
+    CHECK(s.getDepth(OutboundScheduler::AUDIO) == 2);
+    CHECK(s.getDepth(OutboundScheduler::CONTROL) == 1);
+
+    // Audio first once it clears, with the time it waited
+    t.rc = OutboundScheduler::SEND_OK;
+    s.drain(40);
+    CHECK(t.sent.size() == 3 && t.sent[0] == 2 && t.sent[1] == 3 && t.sent[2] == 1);
+    CHECK(s.getStats(OutboundScheduler::AUDIO).maxQueuedMs == 40);
+}
+
+void testSchedulerBusyAudio() {
+    OutboundScheduler s;
+    TestSender t;
+    t.attach(s);
+
+    // A full audio queue drops the oldest
+    t.rc = OutboundScheduler::SEND_BUSY;
+    for (unsigned i = 0; i < OutboundScheduler::QUEUE_DEPTH + 1; i++)
+        submit(s, OutboundScheduler::AUDIO, 1 + i);
+    CHECK(s.getDepth(OutboundScheduler::AUDIO) == OutboundScheduler::QUEUE_DEPTH);
+    CHECK(s.getStats(OutboundScheduler::AUDIO).dropped == 1);
+    // Only the first one tried the network, the rest queued behind it
+    CHECK(s.getStats(OutboundScheduler::AUDIO).busy == 1);
+
+    t.rc = OutboundScheduler::SEND_OK;
+    s.drain(20);
+    CHECK(t.sent.size() == OutboundScheduler::QUEUE_DEPTH && t.sent[0] == 2);
+
+    // New audio doesn't overtake audio that's still waiting
+    t.rc = OutboundScheduler::SEND_BUSY;
+    submit(s, OutboundScheduler::AUDIO, 10);
+    t.rc = OutboundScheduler::SEND_OK;
+    t.sent.clear();
+    submit(s, OutboundScheduler::AUDIO, 11);
+    CHECK(t.sent.empty());
+    s.drain(40);
+    CHECK(t.sent.size() == 2 && t.sent[0] == 10 && t.sent[1] == 11);
+}
+
+void testSchedulerFailed() {
+    OutboundScheduler s;
+    TestSender t;
+    t.attach(s);
+
+    // Failed audio is dropped, not queued
+    t.rc = OutboundScheduler::SEND_FAILED;
+    submit(s, OutboundScheduler::AUDIO, 1);
+    CHECK(s.getDepth(OutboundScheduler::AUDIO) == 0);
+    CHECK(s.getStats(OutboundScheduler::AUDIO).dropped == 1);
+    CHECK(s.getStats(OutboundScheduler::AUDIO).sent == 0);
+
+    // Failed control is abandoned and the drain carries on to the next
+    submit(s, OutboundScheduler::CONTROL, 2);
+    submit(s, OutboundScheduler::CONTROL, 3);
+    t.calls = 0;
+    s.drain(20);
+    CHECK(t.calls == 2);
+    CHECK(s.getDepth(OutboundScheduler::CONTROL) == 0);
+    CHECK(s.getStats(OutboundScheduler::CONTROL).dropped == 2);
+
+    // clear() empties both queues
+    t.rc = OutboundScheduler::SEND_BUSY;
+    submit(s, OutboundScheduler::AUDIO, 4);
+    submit(s, OutboundScheduler::CONTROL, 5);
+    s.clear();
+    CHECK(s.getDepth(OutboundScheduler::AUDIO) == 0);
+    CHECK(s.getDepth(OutboundScheduler::CONTROL) == 0);
+}
+
+// ----- AudioConditioner ---------------------------------------------------
+
+/**
+ * @returns The gain in dB for a tone, measured once the filters have
+ * settled (one second in, over the second second).
+ */
+float conditionerGainDb(AudioConditioner& c, float hz) {
+    const float amplitude = 8000;
+    Tone tone { hz, amplitude };
+    int16_t frame[160];
+    double sum = 0;
+    unsigned n = 0;
+    for (unsigned f = 0; f < 100; f++) {
+        tone.fill(frame, 160);
+        c.process(frame, 160);
+        if (f >= 50) {
+            const float r = rms(frame, 160);
+            sum += r * r;
+            n++;
+        }
+    }
+    return 20.0f * std::log10(std::sqrt(sum / n) / (amplitude / std::sqrt(2.0f)));
+}
+
+void testConditionerHighPass() {
+    AudioConditioner c;
+    c.setHighPass(true);
+    // 4th order Butterworth at 300 Hz: -3 dB at the corner, about -38 dB
+    // an octave and a half below, flat in the voice band
+    CHECK(conditionerGainDb(c, 100) < -30);
+    c.reset();
+    const float corner = conditionerGainDb(c, 300);
+    CHECK(corner > -4.5 && corner < -1.5);
+    c.reset();
+    CHECK(std::fabs(conditionerGainDb(c, 1000)) < 0.5);
+    c.reset();
+    CHECK(std::fabs(conditionerGainDb(c, 3000)) < 0.5);
+}
+
+void testConditionerDeemphasis() {
+    AudioConditioner c;
+    c.setDeemphasis(true);
+    // The first order IIR y = (1 - a)x + a.y1 with a = exp(-T/750us)
+    const double a = std::exp(-1.0 / (8000.0 * 750e-6));
+    for (float hz : { 100.0f, 1000.0f, 2000.0f, 3000.0f }) {
+        const double w = 2.0 * 3.1415926 * hz / 8000.0;
+        const double expected = 20.0 * std::log10((1.0 - a) /
+            std::sqrt(1.0 - 2.0 * a * std::cos(w) + a * a));
+        c.reset();
+        const float got = conditionerGainDb(c, hz);
+        CHECK(std::fabs(got - expected) < 0.5);
+    }
+    // Which is roughly 6 dB/octave in the voice band
+    c.reset();
+    const float g1 = conditionerGainDb(c, 1000);
+    c.reset();
+    const float g2 = conditionerGainDb(c, 2000);
+    CHECK(g1 - g2 > 4.5 && g1 - g2 < 6.5);
+}
+
+void testConditionerAgc() {
+    AudioConditioner c;
+    c.setAgc(true);
+    int16_t frame[160];
+
+    // Silence leaves the gain alone
+    memset(frame, 0, sizeof(frame));
+    c.process(frame, 160);
+    CHECK(c.getAgcGain() == 256);
+
+    // A quiet signal is brought up slowly. After 10 seconds the output
+    // is at the target.
+    Tone quiet { 1000, 2000 };
+    for (unsigned f = 0; f < 25; f++) {
+        quiet.fill(frame, 160);
+        c.process(frame, 160);
+    }
+    CHECK(peak(frame, 160) < AudioConditioner::AGC_TARGET / 2);
+    for (unsigned f = 25; f < 500; f++) {
+        quiet.fill(frame, 160);
+        c.process(frame, 160);
+    }
+    CHECK(std::abs(peak(frame, 160) - AudioConditioner::AGC_TARGET) <
+        AudioConditioner::AGC_TARGET / 20);
+
+    // A loud one is pulled down within a few frames
+    Tone loud { 1000, 24000 };
+    for (unsigned f = 0; f < 25; f++) {
+        loud.fill(frame, 160);
+        c.process(frame, 160);
+    }
+    CHECK(std::abs(peak(frame, 160) - AudioConditioner::AGC_TARGET) <
+        AudioConditioner::AGC_TARGET / 20);
+
+    // The gain stays within its limits
+    Tone faint { 1000, 100 };
+    for (unsigned f = 0; f < 3000; f++) {
+        faint.fill(frame, 160);
+        c.process(frame, 160);
+    }
+    CHECK(c.getAgcGain() == AudioConditioner::AGC_MAX_GAIN);
+}
+
+// ----- ToneDetector -------------------------------------------------------
+
+/**
+ * Feeds ms of the sum of the tones through the detector in 160 sample
+ * frames, collecting the events.
+ */
+void feedTones(ToneDetector& d, vector<Tone*> tones, unsigned ms,
+    vector<ToneDetector::Event>& events) {
+    int16_t frame[160], part[160];
+    for (unsigned f = 0; f < ms / 20; f++) {
+        memset(frame, 0, sizeof(frame));
+        for (Tone* t : tones) {
+            t->fill(part, 160);
+            for (unsigned i = 0; i < 160; i++)
+                frame[i] += part[i];
+        }
+        ToneDetector::Event e[4];
+        const unsigned n = d.process(frame, 160, e, 4);
+        events.insert(events.end(), e, e + n);
+    }
+}
+
+void testToneCtcss() {
+    ToneDetector d;
+    d.addCtcssTone(1000);
+    d.addCtcssTone(1318);
+    vector<ToneDetector::Event> ev;
+
+    // Voice alone
+    Tone voice { 900, 8000 };
+    feedTones(d, { &voice }, 2000, ev);
+    CHECK(ev.empty());
+    CHECK(d.getActiveCtcss() == 0);
+
+    // A low level tone under the voice
+    Tone ctcss { 100.0f, 1500 };
+    feedTones(d, { &voice, &ctcss }, 2000, ev);
+    CHECK(ev.size() == 1 && ev[0].kind == ToneDetector::Event::CTCSS_ON &&
+        ev[0].freqTenths == 1000);
+    CHECK(d.getActiveCtcss() == 1000);
+
+    // Gone
+    ev.clear();
+    feedTones(d, { &voice }, 2000, ev);
+    CHECK(ev.size() == 1 && ev[0].kind == ToneDetector::Event::CTCSS_OFF &&
+        ev[0].freqTenths == 1000);
+    CHECK(d.getActiveCtcss() == 0);
+
+    // The other watched tone
+    ev.clear();
+    Tone other { 131.8f, 1500 };
+    feedTones(d, { &voice, &other }, 2000, ev);
+    CHECK(ev.size() == 1 && ev[0].kind == ToneDetector::Event::CTCSS_ON &&
+        ev[0].freqTenths == 1318);
+
+    // A tone that isn't watched
+    d.reset();
+    ev.clear();
+    Tone unwatched { 107.2f, 1500 };
+    feedTones(d, { &voice, &unwatched }, 2000, ev);
+    CHECK(ev.empty());
+}
+
+void testToneDtmf() {
+    ToneDetector d;
+    d.setDtmfEnabled(true);
+    vector<ToneDetector::Event> ev;
+    Tone silence { 0, 0 };
+
+    // 5 (770 + 1336) and # (941 + 1477)
+    Tone r5 { 770, 6000 }, c5 { 1336, 6000 };
+    Tone rh { 941, 6000 }, ch { 1477, 6000 };
+    feedTones(d, { &r5, &c5 }, 100, ev);
+    feedTones(d, { &silence }, 100, ev);
+    feedTones(d, { &rh, &ch }, 100, ev);
+    feedTones(d, { &silence }, 100, ev);
+    CHECK(ev.size() == 2);
+    CHECK(ev.size() == 2 && ev[0].kind == ToneDetector::Event::DTMF &&
+        ev[0].digit == '5' && ev[1].digit == '#');
+
+    // A held digit is reported once, and again after it's released
+    ev.clear();
+    feedTones(d, { &r5, &c5 }, 500, ev);
+    CHECK(ev.size() == 1);
+    feedTones(d, { &silence }, 100, ev);
+    feedTones(d, { &r5, &c5 }, 100, ev);
+    CHECK(ev.size() == 2);
+
+    // Too short, and a single frequency
+    ev.clear();
+    feedTones(d, { &silence }, 100, ev);
+    feedTones(d, { &rh, &ch }, 20, ev);
+    feedTones(d, { &silence }, 100, ev);
+    feedTones(d, { &rh }, 200, ev);
+    CHECK(ev.empty());
+}
+
+void testToneGate() {
+    // The VoterClient's tone gate passes audio while isCtcssGateOpen()
+    ToneDetector d;
+    d.addCtcssTone(1000);
+    vector<ToneDetector::Event> ev;
+    Tone voice { 900, 8000 };
+    Tone ctcss { 100.0f, 1500 };
+
+    // Closed on voice alone, no matter how long
+    for (unsigned ms = 20; ms <= 10000; ms += 20) {
+        feedTones(d, { &voice }, 20, ev);
+        CHECK(!d.isCtcssGateOpen());
+    }
+
+    // Open within 0.4s of the tone arriving (ahead of getActiveCtcss()),
+    // and stays open
+    unsigned openMs = 0, activeMs = 0;
+    bool stayed = true;
+    for (unsigned ms = 20; ms <= 3000; ms += 20) {
+        feedTones(d, { &voice, &ctcss }, 20, ev);
+        if (d.isCtcssGateOpen() && !openMs)
+            openMs = ms;
+        else if (openMs && !d.isCtcssGateOpen())
+            stayed = false;
+        if (d.getActiveCtcss() && !activeMs)
+            activeMs = ms;
+    }
+    CHECK(openMs && openMs <= 400);
+    CHECK(activeMs && openMs < activeMs);
+    CHECK(stayed);
+
+    // Closed within 0.6s of the tone leaving (the rest of the block it
+    // left in plus two missed blocks), well before getActiveCtcss() lets 
+    // go
+    unsigned closedMs = 0, inactiveMs = 0;
+    for (unsigned ms = 20; ms <= 3000 && !inactiveMs; ms += 20) {
+        feedTones(d, { &voice }, 20, ev);
+        if (!d.isCtcssGateOpen() && !closedMs)
+            closedMs = ms;
+        if (!d.getActiveCtcss())
+            inactiveMs = ms;
+    }
+    CHECK(closedMs && closedMs <= 600);
+    CHECK(inactiveMs && closedMs < inactiveMs);
+
+    // The tone arriving part way into a block
+    d.reset();
+    feedTones(d, { &voice }, 140, ev);
+    openMs = 0;
+    for (unsigned ms = 20; ms <= 1000 && !openMs; ms += 20) {
+        feedTones(d, { &voice, &ctcss }, 20, ev);
+        if (d.isCtcssGateOpen())
+            openMs = ms;
+    }
+    CHECK(openMs && openMs <= 400);
+
+    // ... and leaving part way into one
+    feedTones(d, { &voice, &ctcss }, 2060, ev);
+    CHECK(d.isCtcssGateOpen());
+    closedMs = 0;
+    for (unsigned ms = 20; ms <= 1000 && !closedMs; ms += 20) {
+        feedTones(d, { &voice }, 20, ev);
+        if (!d.isCtcssGateOpen())
+            closedMs = ms;
+    }
+    CHECK(closedMs && closedMs <= 600);
+
+    // A tone too close for the short block to tell apart (2 Hz away) 
+    // may open the gate, but the long block shuts it within 1.5s
+    d.reset();
+    Tone nearby { 102.0f, 1500 };
+    unsigned lastOpenMs = 0;
+    for (unsigned ms = 20; ms <= 5000; ms += 20) {
+        feedTones(d, { &voice, &nearby }, 20, ev);
+        if (d.isCtcssGateOpen())
+            lastOpenMs = ms;
+    }
+    CHECK(lastOpenMs <= 1500);
+    CHECK(d.getActiveCtcss() == 0);
+
+    // The next standard tone up (103.5 Hz) never opens it
+    d.reset();
+    Tone next { 103.5f, 1500 };
+    for (unsigned ms = 20; ms <= 5000; ms += 20) {
+        feedTones(d, { &voice, &next }, 20, ev);
+        CHECK(!d.isCtcssGateOpen());
+    }
+
+    // A tone further away (107.2 Hz) never opens it
+    d.reset();
+    Tone unwatched { 107.2f, 1500 };
+    for (unsigned ms = 20; ms <= 5000; ms += 20) {
+        feedTones(d, { &voice, &unwatched }, 20, ev);
+        CHECK(!d.isCtcssGateOpen());
+    }
+}
+
+// ----- TickAligner ---------------------------------------------------------
+
+struct TickRecorder : public Runnable2 {
+    vector<uint32_t> ticks;
+    virtual void audioRateTick(uint32_t tickTimeMs) { ticks.push_back(tickTimeMs); }
+};
+
+/**
+ * Runs an aligner for 20 seconds of virtual time against a server whose
+ * clock is offsetMs ahead of the local one and which sends a frame on 
+ * each of its 20ms boundaries. Each frame takes delayMs plus 0 to 
+ * jitterMs to arrive. The round trip is given as the client would 
+ * measure it (twice the least delay). The server's time is epochMs 
+ * plus that and is passed through a packet header, the same as 
+ * VoterClient does it.
+ *
+ * @returns The largest phase error (against the server's real 
+ * boundaries) over the last 10 seconds, or -1 if it never locked.
+ */
+int alignerWorstPhaseError(int32_t offsetMs, uint32_t delayMs, uint32_t jitterMs,
+    uint64_t epochMs = 0) {
+
+    Log log;
+    SimClock clock;
+    TickRecorder rec;
+    Runnable2* children[] = { &rec };
+    TickAligner aligner(log, clock, children, 1);
+
+    struct Frame { uint64_t serverMs; uint32_t rxMs; };
+    vector<Frame> inFlight;
+    uint32_t rand = 1;
+
+    // The local clock doesn't start at 0 so that the server's boundaries
+    // aren't on local ones
+    const uint32_t startMs = 1003;
+    const uint32_t endMs = startMs + 20000;
+    for (uint32_t now = startMs; now < endMs; now++) {
+        clock.set(now);
+        const uint64_t serverMs = epochMs + now + offsetMs;
+        if (serverMs % TickAligner::TICK_MS == 0) {
+            rand = rand * 1103515245 + 12345;
+            const uint32_t j = jitterMs ? (rand >> 16) % (jitterMs + 1) : 0;
+            inFlight.push_back({ serverMs, now + delayMs + j });
+        }
+        for (auto it = inFlight.begin(); it != inFlight.end(); ) {
+            if (it->rxMs == now) {
+                uint8_t packet[voter::HEADER_SIZE];
+                voter::writeHeader(packet, it->serverMs / 1000, 
+                    (it->serverMs % 1000) * 1000000, "", 0, voter::PAYLOAD_NONE);
+                aligner.observeServerTime(voter::getWrappedTimeMs(packet), 
+                    it->rxMs, 2 * delayMs);
+                it = inFlight.erase(it);
+            }
+            else 
+                it++;
+        }
+        aligner.run2();
+    }
+
+    if (!aligner.isLocked())
+        return -1;
+    int worst = 0;
+    for (uint32_t t : rec.ticks) {
+        if (t < endMs - 10000)
+            continue;
+        int e = (int)((epochMs + t + offsetMs) % TickAligner::TICK_MS);
+        if (e > (int)TickAligner::TICK_MS / 2)
+            e -= TickAligner::TICK_MS;
+        worst = std::max(worst, std::abs(e));
+    }
+    return worst;
+}
+
+void testAlignerPhaseLock() {
+    // Offset, delay, jitter
+    const int32_t cases[][3] = {
+        { 7, 30, 0 },
+        { 13, 5, 0 },
+        { -4, 30, 10 },
+        { 19, 45, 10 },
+        { 0, 80, 30 },
+    };
+    for (auto& c : cases) {
+        const int e = alignerWorstPhaseError(c[0], c[1], c[2]);
+        if (e < 0 || e > TickAligner::LOCK_LIMIT_MS)
+            printf("  offset %d delay %d jitter %d: worst phase error %d\n",
+                c[0], c[1], c[2], e);
+        CHECK(e >= 0 && e <= TickAligner::LOCK_LIMIT_MS);
+    }
+}
+
+void testAlignerEpochTime() {
+    // A real server stamps packets with UTC. 2^32 ms isn't a whole 
+    // number of frames so a 32-bit truncation puts the phase off.
+    const uint64_t utcMs = 1792345678901ull;
+    int e = alignerWorstPhaseError(7, 30, 10, utcMs);
+    CHECK(e >= 0 && e <= TickAligner::LOCK_LIMIT_MS);
+
+    // The wrapped server time passes voter::TIME_WRAP_MS half way 
+    // through the run
+    const uint64_t wrapMs = 1340ull * voter::TIME_WRAP_MS - 1003 - 10000;
+    e = alignerWorstPhaseError(7, 30, 10, wrapMs);
+    CHECK(e >= 0 && e <= TickAligner::LOCK_LIMIT_MS);
+}
+
+void testAlignerRttAgesOut() {
+    // The server is 7ms ahead and packets take 30ms. A round trip that
+    // reads too low puts the offset off, but only until it leaves the
+    // windows.
+    Log log;
+    SimClock clock;
+    TickRecorder rec;
+    Runnable2* children[] = { &rec };
+    TickAligner aligner(log, clock, children, 1);
+    uint32_t rx = 1000;
+    for (unsigned i = 0; i < 10; i++, rx += 20)
+        aligner.observeServerTime(rx + 7 - 30, rx, 10);
+    CHECK(aligner.getServerOffset() == 2);
+    for (unsigned i = 0; i < 2 * TickAligner::WINDOW_SAMPLES; i++, rx += 20)
+        aligner.observeServerTime(rx + 7 - 30, rx, 60);
+    CHECK(aligner.getServerOffset() == 7);
+}
+
+void testAlignerFixedOffset() {
+    Log log;
+    SimClock clock;
+    TickRecorder rec;
+    Runnable2* children[] = { &rec };
+    TickAligner aligner(log, clock, children, 1);
+    aligner.setServerOffset(11);
+    for (uint32_t now = 500; now < 3500; now++) {
+        clock.set(now);
+        aligner.run2();
+    }
+    CHECK(aligner.isLocked());
+    CHECK(!rec.ticks.empty() && (rec.ticks.back() + 11) % TickAligner::TICK_MS == 0);
+    // One tick per 20ms, give or take the nudges at the start
+    CHECK(rec.ticks.size() >= 145 && rec.ticks.size() <= 151);
+}
+
+// ----- RttProbe -------------------------------------------------------------
+
+void testRttProbeCrossingKeepalive() {
+    RttProbe probe;
+    uint8_t p1[RttProbe::PAYLOAD_SIZE], p2[RttProbe::PAYLOAD_SIZE];
+    uint32_t rtt = 0;
+
+    // The first probe goes out and the server's keepalive crosses it on
+    // the way. The keepalive has no payload so it isn't the reply.
+    CHECK(probe.makeProbe(1000, p1) == RttProbe::PAYLOAD_SIZE);
+    probe.sent(p1, sizeof(p1), 1000);
+    CHECK(!probe.isReply(0, 0, 1010, rtt));
+    CHECK(probe.makeProbe(1020, p2) == 0);
+
+    // The reply is lost. The probe times out and the next one goes out.
+    CHECK(probe.isPending(1999));
+    CHECK(!probe.isPending(2000));
+    CHECK(probe.makeProbe(2000, p2) == RttProbe::PAYLOAD_SIZE);
+    probe.sent(p2, sizeof(p2), 2005);
+
+    // Another keepalive, then a late reply to the first probe, neither
+    // of which is the reply
+    CHECK(!probe.isReply(0, 0, 2010, rtt));
+    CHECK(!probe.isReply(p1, sizeof(p1), 2015, rtt));
+    CHECK(rtt == 0);
+
+    // A short or damaged echo doesn't count either
+    CHECK(!probe.isReply(p2, sizeof(p2) - 1, 2050, rtt));
+    uint8_t bad[RttProbe::PAYLOAD_SIZE];
+    memcpy(bad, p2, sizeof(bad));
+    bad[7] ^= 1;
+    CHECK(!probe.isReply(bad, sizeof(bad), 2055, rtt));
+
+    // The real reply
+    CHECK(probe.isReply(p2, sizeof(p2), 2065, rtt));
+    CHECK(rtt == 60);
+    // ... only once
+    CHECK(!probe.isReply(p2, sizeof(p2), 2070, rtt));
+    CHECK(!probe.isPending(2070));
+}
+
+void testRttProbeNotSent() {
+    // A probe that never got out (i.e. dropped by the scheduler) holds
+    // up the next one for the timeout only
+    RttProbe probe;
+    uint8_t p[RttProbe::PAYLOAD_SIZE];
+    uint32_t rtt = 0;
+    CHECK(probe.makeProbe(500, p) == RttProbe::PAYLOAD_SIZE);
+    CHECK(!probe.isReply(p, sizeof(p), 520, rtt));
+    CHECK(probe.makeProbe(1499, p) == 0);
+    CHECK(probe.makeProbe(1500, p) == RttProbe::PAYLOAD_SIZE);
+}
+
+// ----- Transcoder_IMA_ADPCM -------------------------------------------------
+
+void testAdpcmRoundTrip() {
+    const unsigned FRAMES = 10;
+    const unsigned N = Transcoder_IMA_ADPCM::FRAME_SAMPLES;
+    // A 1 kHz tone that fades in over the first frame
+    int16_t pcm[FRAMES * N];
+    for (unsigned i = 0; i < FRAMES * N; i++) {
+        const float level = i < N ? (float)i / N : 1.0f;
+        pcm[i] = (int16_t)(level * 8000.0f * std::sin(2.0f * M_PI * 1000.0f * i / 8000.0f));
+    }
+
+    Transcoder_IMA_ADPCM enc, dec;
+    uint8_t frames[FRAMES][Transcoder_IMA_ADPCM::FRAME_SIZE];
+    int16_t out[FRAMES * N];
+    for (unsigned f = 0; f < FRAMES; f++) {
+        CHECK(enc.encode(pcm + f * N, N, frames[f], sizeof(frames[f])) == 
+            Transcoder_IMA_ADPCM::FRAME_SIZE);
+        CHECK(dec.decode(frames[f], sizeof(frames[f]), out + f * N, N) == N);
+    }
+
+    // Once the encoder has caught up with the fade the error is small
+    double sig = 0, err = 0;
+    for (unsigned i = 2 * N; i < FRAMES * N; i++) {
+        sig += (double)pcm[i] * pcm[i];
+        err += (double)(out[i] - pcm[i]) * (out[i] - pcm[i]);
+    }
+    CHECK(10.0 * std::log10(sig / err) > 15.0);
+
+    // Each frame carries its starting state, so a decoder that missed
+    // the earlier frames gives the same samples
+    Transcoder_IMA_ADPCM late;
+    int16_t alone[N];
+    CHECK(late.decode(frames[7], sizeof(frames[7]), alone, N) == N);
+    CHECK(memcmp(alone, out + 7 * N, sizeof(alone)) == 0);
+
+    // No room, or not enough input
+    uint8_t small[Transcoder_IMA_ADPCM::FRAME_SIZE - 1];
+    CHECK(enc.encode(pcm, N, small, sizeof(small)) == 0);
+    CHECK(late.decode(frames[0], Transcoder_IMA_ADPCM::HEADER_SIZE - 1, alone, N) == 0);
+}
+
+// ----- VoterAuth ------------------------------------------------------------
+
+void testAuthDigestCache() {
+    VoterAuth auth;
+    auth.setLocalChallenge("abcdefghij");
+    auth.setLocalPassword("client0");
+    auth.setRemotePassword("parrot0");
+    CHECK(auth.getInboundDigest() == voter::crc32("abcdefghij", "parrot0"));
+    // Nothing to sign with until the server's challenge is known
+    CHECK(auth.getOutboundDigest() == 0);
+
+    uint8_t packet[voter::HEADER_SIZE];
+    voter::writeHeader(packet, 1000, 5000000, "1234567890", 
+        auth.getInboundDigest(), voter::PAYLOAD_ULAW);
+    CHECK(voter::getTimeSec(packet) == 1000);
+    CHECK(voter::getTimeNsec(packet) == 5000000);
+    CHECK(memcmp(packet + voter::OFFSET_CHALLENGE, "1234567890", 10) == 0);
+    CHECK(voter::getDigest(packet) == auth.getInboundDigest());
+    CHECK(voter::getPayloadType(packet) == voter::PAYLOAD_ULAW);
+
+    CHECK(auth.isInboundAuthentic(packet));
+    const uint32_t computed = auth.getComputeCount();
+    auth.observeRemoteChallenge(packet);
+    CHECK(auth.getOutboundDigest() == voter::crc32("1234567890", "client0"));
+    CHECK(auth.getComputeCount() == computed + 1);
+
+    // The same challenge packet after packet costs nothing
+    for (unsigned i = 0; i < 100; i++) {
+        CHECK(auth.isInboundAuthentic(packet));
+        auth.observeRemoteChallenge(packet);
+    }
+    CHECK(auth.getComputeCount() == computed + 1);
+
+    // A different digest isn't accepted
+    voter::pack32(packet + voter::OFFSET_DIGEST, auth.getInboundDigest() ^ 0x100);
+    CHECK(!auth.isInboundAuthentic(packet));
+
+    // A new server challenge (i.e. a restart) is picked up, and a short
+    // one is padded with nulls
+    voter::writeHeader(packet, 0, 0, "98765", auth.getInboundDigest(), 
+        voter::PAYLOAD_NONE);
+    CHECK(packet[voter::OFFSET_CHALLENGE + 5] == 0 && 
+        packet[voter::OFFSET_CHALLENGE + 9] == 0);
+    auth.observeRemoteChallenge(packet);
+    CHECK(auth.getOutboundDigest() == voter::crc32("98765", "client0"));
+    CHECK(auth.getComputeCount() == computed + 2);
+}
+
+// ----- TelemetryRecord ------------------------------------------------------
+
+void testTelemetryRoundTrip() {
+
+    // Every field gets a different value, with the top bit set where 
+    // there is room so that a truncated or swapped field shows up
+    telemetry::Snapshot s;
+    strcpy(s.nodeId, "E6614103E7452D2F");
+    s.lineCount = telemetry::MAX_LINES;
+    s.sequence = 0x80000001;
+    s.uptimeSec = 0x80000002;
+    s.intervalSec = 0x8003;
+    s.flags = telemetry::FLAG_ALIGNED | telemetry::FLAG_LOCKED;
+    s.phaseErrorMs = -7;
+    s.maxTickGapMs = 0x8004;
+    s.loopPasses = 0x80000005;
+    s.audioTicks = 0x80000006;
+    for (unsigned i = 0; i < telemetry::TICK_HIST_BUCKETS; i++)
+        s.tickHist[i] = 0x80000010 + i;
+    s.logOverflows = 0x80000007;
+    s.net.rxPackets = 0x80000008;
+    s.net.rxOverflows = 0x80000009;
+    s.net.txPackets = 0x8000000a;
+    s.net.txErrors = 0x8000000b;
+    for (unsigned n = 0; n < telemetry::MAX_LINES; n++) {
+        telemetry::LineStats& l = s.lines[n];
+        const uint32_t b = 0x100 * (n + 1);
+        l.lineId = 24 + n;
+        l.flags = telemetry::LINE_FLAG_ADPCM;
+        l.rssi = 0x80 + n;
+        l.rttMinMs = 0x8000 + b + 1;
+        l.rttMeanMs = 0x8000 + b + 2;
+        l.rttP95Ms = 0x8000 + b + 3;
+        l.rttMaxMs = 0x8000 + b + 4;
+        l.rttCount = 0x80000000 + b + 5;
+        l.authRejects = 0x80000000 + b + 6;
+        l.audioSent = 0x80000000 + b + 7;
+        l.audioDropped = 0x80000000 + b + 8;
+        l.audioBusy = 0x80000000 + b + 9;
+        l.audioMaxQueuedMs = 0x8000 + b + 10;
+        l.controlSent = 0x80000000 + b + 11;
+        l.controlDropped = 0x80000000 + b + 12;
+        for (unsigned i = 0; i < telemetry::RTT_HIST_BUCKETS; i++)
+            l.rttHist[i] = 0x8000 + b + 16 + i;
+    }
+
+    uint8_t buf[telemetry::RECORD_SIZE + 16];
+    CHECK(telemetry::encode(s, buf, telemetry::RECORD_SIZE - 1) == 0);
+    CHECK(telemetry::encode(s, buf, sizeof(buf)) == telemetry::RECORD_SIZE);
+
+    telemetry::Snapshot d;
+    CHECK(telemetry::decode(buf, telemetry::RECORD_SIZE, d) == 0);
+    CHECK(strcmp(d.nodeId, s.nodeId) == 0);
+    CHECK(d.lineCount == s.lineCount);
+    CHECK(d.sequence == s.sequence);
+    CHECK(d.uptimeSec == s.uptimeSec);
+    CHECK(d.intervalSec == s.intervalSec);
+    CHECK(d.flags == s.flags);
+    CHECK(d.phaseErrorMs == s.phaseErrorMs);
+    CHECK(d.maxTickGapMs == s.maxTickGapMs);
+    CHECK(d.loopPasses == s.loopPasses);
+    CHECK(d.audioTicks == s.audioTicks);
+    for (unsigned i = 0; i < telemetry::TICK_HIST_BUCKETS; i++)
+        CHECK(d.tickHist[i] == s.tickHist[i]);
+    CHECK(d.logOverflows == s.logOverflows);
+    CHECK(d.net.rxPackets == s.net.rxPackets);
+    CHECK(d.net.rxOverflows == s.net.rxOverflows);
+    CHECK(d.net.txPackets == s.net.txPackets);
+    CHECK(d.net.txErrors == s.net.txErrors);
+    for (unsigned n = 0; n < telemetry::MAX_LINES; n++) {
+        const telemetry::LineStats& a = s.lines[n];
+        const telemetry::LineStats& b = d.lines[n];
+        CHECK(b.lineId == a.lineId);
+        CHECK(b.flags == a.flags);
+        CHECK(b.rssi == a.rssi);
+        CHECK(b.rttMinMs == a.rttMinMs);
+        CHECK(b.rttMeanMs == a.rttMeanMs);
+        CHECK(b.rttP95Ms == a.rttP95Ms);
+        CHECK(b.rttMaxMs == a.rttMaxMs);
+        CHECK(b.rttCount == a.rttCount);
+        CHECK(b.authRejects == a.authRejects);
+        CHECK(b.audioSent == a.audioSent);
+        CHECK(b.audioDropped == a.audioDropped);
+        CHECK(b.audioBusy == a.audioBusy);
+        CHECK(b.audioMaxQueuedMs == a.audioMaxQueuedMs);
+        CHECK(b.controlSent == a.controlSent);
+        CHECK(b.controlDropped == a.controlDropped);
+        for (unsigned i = 0; i < telemetry::RTT_HIST_BUCKETS; i++)
+            CHECK(b.rttHist[i] == a.rttHist[i]);
+    }
+
+    // Short datagrams and other versions are rejected
+    CHECK(telemetry::decode(buf, telemetry::RECORD_SIZE - 1, d) == -1);
+    buf[4] = telemetry::VERSION - 1;
+    CHECK(telemetry::decode(buf, telemetry::RECORD_SIZE, d) == -1);
+}
+
+struct Test {
+    const char* name;
+    void (*fn)();
+};
+
+const Test tests[] = {
+    { "scheduler_audio_immediate", testSchedulerAudioImmediate },
+    { "scheduler_control_tokens", testSchedulerControlTokens },
+    { "scheduler_priority", testSchedulerPriority },
+    { "scheduler_busy_audio", testSchedulerBusyAudio },
+    { "scheduler_failed", testSchedulerFailed },
+    { "conditioner_high_pass", testConditionerHighPass },
+    { "conditioner_deemphasis", testConditionerDeemphasis },
+    { "conditioner_agc", testConditionerAgc },
+    { "tone_ctcss", testToneCtcss },
+    { "tone_dtmf", testToneDtmf },
+    { "tone_gate", testToneGate },
+    { "aligner_phase_lock", testAlignerPhaseLock },
+    { "aligner_epoch_time", testAlignerEpochTime },
+    { "aligner_rtt_ages_out", testAlignerRttAgesOut },
+    { "aligner_fixed_offset", testAlignerFixedOffset },
+    { "rtt_probe_crossing_keepalive", testRttProbeCrossingKeepalive },
+    { "rtt_probe_not_sent", testRttProbeNotSent },
+    { "adpcm_round_trip", testAdpcmRoundTrip },
+    { "auth_digest_cache", testAuthDigestCache },
+    { "telemetry_round_trip", testTelemetryRoundTrip },
+};
+
+}
+
+int main(int argc, const char** argv) {
+
+    const char* filter = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else {
+            fprintf(stderr, "usage: voter-test [--filter SUBSTRING]\n");
+            return 1;
+        }
+    }
+
+    unsigned run = 0;
+    for (const Test& t : tests) {
+        if (filter && !strstr(t.name, filter))
+            continue;
+        const unsigned before = failures;
+        t.fn();
+        printf("%-32s %s\n", t.name, failures == before ? "ok" : "FAILED");
+        run++;
+    }
+    printf("%u tests, %u failed checks\n", run, failures);
+    return failures ? 1 : 0;
+}
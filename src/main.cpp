@@ -17,6 +17,7 @@
 #include <stdio.h>
 
 #include "pico/stdlib.h"
+#include "pico/unique_id.h"
 #include "pico/cyw43_arch.h"
 #include "hardware/gpio.h"
 
@@ -32,12 +33,29 @@
 #include "SimpleRouter.h"
 
 #include "VoterClient.h"
+#include "VoterMux.h"
 #include "SignalGenerator.h"
+#include "AudioOutput.h"
+#include "PwmAudioDriver.h"
+#include "HeapGuard.h"
+#include "DeferredLog.h"
+#include "TickAligner.h"
+#include "StaticTaskGraph.h"
+#include "TelemetryExporter.h"
+#include "microip_stats.h"
 
 #define LED_PIN (25)
 
+// Each receiver has its own VOTER line and its own generator line
 #define LINE_ID_VOTER (24)
 #define LINE_ID_GENERATOR (25)
+#define LINE_ID_VOTER_B (26)
+#define LINE_ID_GENERATOR_B (27)
+// Local monitor of the audio coming back from the server
+#define LINE_ID_AUDIO_OUT (28)
+
+// PWM audio output (needs an RC filter)
+#define AUDIO_PWM_PIN (16)
 
 using namespace std;
 using namespace kc1fsz;
@@ -46,6 +64,18 @@ static const char* VERSION = "20260219.0";
 const char ssid[] = "Gloucester Island Municipal WIFI";
 const char wifiPwd[] = "xxx";
 
+// The telemetry collector (addr:port) and the seconds between records 
+// come from the build (see CMakeLists.txt) until there is a settings 
+// store for these and the server settings. An empty collector turns 
+// telemetry off.
+#ifndef AMP_VOTER_TELEMETRY_COLLECTOR
+#define AMP_VOTER_TELEMETRY_COLLECTOR ""
+#endif
+#ifndef AMP_VOTER_TELEMETRY_INTERVAL
+#define AMP_VOTER_TELEMETRY_INTERVAL (60)
+#endif
+const char telemetryCollector[] = AMP_VOTER_TELEMETRY_COLLECTOR;
+
 int main() {
     
     stdio_init_all();
@@ -95,24 +125,118 @@ int main() {
         }
     );
 
-    // Setup link to the VOTER server
+    // Hot-path errors are formatted later, outside of the audio tick
+    DeferredLog dlog(log, clock);
+
+    // All receivers share one socket to the VOTER server
+    VoterMux mux(log, clock);
+    mux.setDeferredLog(&dlog);
+    if (mux.open(AF_INET) != 0) {
+        log.error("Failed to open shared socket");
+    }
+
+    // Setup links to the VOTER server, one per receiver. Each line
+    // needs its own client password so the server can tell them apart.
     VoterClient client24(log, clock, LINE_ID_VOTER, router);
+    client24.setDeferredLog(&dlog);
     router.addRoute(&client24, LINE_ID_VOTER);
     // #### TODO REMOVE HARD-CODING
     client24.setClientPassword("client0");
     client24.setServerPassword("parrot0");
-    int rc = client24.open("52.8.247.112:1667");
+    int rc = client24.open("52.8.247.112:1667", mux);
     if (rc != 0) {
         log.error("Failed to open connection");
     }
 
+    VoterClient client26(log, clock, LINE_ID_VOTER_B, router);
+    client26.setDeferredLog(&dlog);
+    router.addRoute(&client26, LINE_ID_VOTER_B);
+    // #### TODO REMOVE HARD-CODING
+    client26.setClientPassword("client1");
+    client26.setServerPassword("parrot0");
+    rc = client26.open("52.8.247.112:1667", mux);
+    if (rc != 0) {
+        log.error("Failed to open connection");
+    }
+
+    // Strip CTCSS and level the audio before it goes to the server
+    client24.getConditioner().setHighPass(true);
+    client24.getConditioner().setAgc(true);
+    client26.getConditioner().setHighPass(true);
+    client26.getConditioner().setAgc(true);
+
     // Can be used in inject tones
     SignalGenerator generator25(log, clock, LINE_ID_GENERATOR, router, LINE_ID_VOTER);
     router.addRoute(&generator25, LINE_ID_GENERATOR);
+    SignalGenerator generator27(log, clock, LINE_ID_GENERATOR_B, router, LINE_ID_VOTER_B, 
+        600.0f);
+    router.addRoute(&generator27, LINE_ID_GENERATOR_B);
+
+    // The voted audio is the same on every line so only one is monitored
+    AudioOutput audioOut(log, clock);
+    router.addRoute(&audioOut, LINE_ID_AUDIO_OUT);
+    client24.setAudioOutputLine(LINE_ID_AUDIO_OUT);
+    PwmAudioDriver pwmOut(audioOut, AUDIO_PWM_PIN);
+    pwmOut.start();
+
+    // Watches for heap use once we are in steady state
+    HeapGuard heapGuard(log);
+
+    // The receive lines send on the server's 20ms frame boundaries. 
+    // They get their audio tick from the aligner, not the event loop.
+#ifdef AMP_VOTER_TASK_GRAPH
+    StaticTaskGraph alignedGraph(client24, client26, generator25, generator27);
+    Runnable2* alignedTasks[] = { &alignedGraph };
+#else
+    Runnable2* alignedTasks[] = { &client24, &client26, &generator25, &generator27 };
+#endif
+    TickAligner aligner(log, clock, alignedTasks, std::size(alignedTasks));
+    client24.setServerTimeObserver([&aligner](uint32_t serverMs, uint32_t rxMs, 
+        uint32_t rttMs) {
+        aligner.observeServerTime(serverMs, rxMs, rttMs);
+    });
+
+    // Stats go out to the collector, if there is one
+    TelemetryExporter telemetry(log, clock);
+    telemetry.setIntervalSec(AMP_VOTER_TELEMETRY_INTERVAL);
+    if (telemetry.addLine(&client24) != 0 || telemetry.addLine(&client26) != 0) {
+        log.error("Failed to add telemetry line");
+    }
+    telemetry.setAligner(&aligner);
+    telemetry.setDeferredLog(&dlog);
+    telemetry.setNetStatsSource([](telemetry::NetCounters& n) {
+        microip_stats ms;
+        microip_get_stats(&ms);
+        n.rxPackets = ms.rxPackets;
+        n.rxOverflows = ms.rxOverflows;
+        n.txPackets = ms.txPackets;
+        n.txErrors = ms.txErrors;
+    });
+    // The collector knows the voter by the board's unique ID
+    char boardId[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+    pico_get_unique_board_id_string(boardId, sizeof(boardId));
+    telemetry.setNodeId(boardId);
+    if (telemetryCollector[0] == 0) {
+        log.info("No telemetry collector");
+    } else if (telemetry.open(telemetryCollector) != 0) {
+        log.error("Failed to open telemetry");
+    }
 
-    // Main loop        
-    Runnable2* tasks2[] = { &cy34Task, &timer1, &client24, &generator25 };
+    // Main loop. The graph only calls the hooks that each task implements,
+    // without going through the vtable. Build with AMP_VOTER_TASK_GRAPH 
+    // off to compare (the event loop passes/s are logged by the 
+    // TelemetryExporter).
+#ifdef AMP_VOTER_TASK_GRAPH
+    StaticTaskGraph graph(cy34Task, timer1, mux, aligner, audioOut, pwmOut, 
+        heapGuard, dlog, telemetry);
+    Runnable2* tasks2[] = { &graph };
+#else
+    Runnable2* tasks2[] = { &cy34Task, &timer1, &mux, &aligner, &audioOut, &pwmOut,
+        &heapGuard, &dlog, &telemetry };
+#endif
     log.info("Entering event loop ...");
+    // Nothing should touch the heap after this point
+    heapGuard.arm();
     PicoEventLoop::run(log, clock, 0, 0, tasks2, std::size(tasks2), nullptr, false);
 }
 